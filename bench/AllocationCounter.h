@@ -0,0 +1,25 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __FLOODING_ALLOCATIONCOUNTER_H_
+#define __FLOODING_ALLOCATIONCOUNTER_H_
+
+#include <stdint.h>
+
+// Number of calls to the global operator new since the program started. Only counted in the benchmark binary,
+// which replaces operator new and delete.
+uint64_t allocationCount();
+
+#endif
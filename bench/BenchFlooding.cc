@@ -0,0 +1,110 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "BenchFlooding.h"
+
+#include <chrono>
+#include <cstdio>
+
+Define_Module(BenchFlooding);
+
+typedef std::chrono::steady_clock Clock;
+
+static inline int64_t elapsedNanoseconds(const Clock::time_point& start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+void BenchFlooding::initialize(int stage) {
+    Flooding::initialize(stage);
+
+    if (stage == 0)
+        profileFunctions = par("profileFunctions").boolValue();
+}
+
+void BenchFlooding::finish() {
+    Flooding::finish();
+
+    if (profileFunctions) {
+        reportFunction("extractMsgInfo", extractMsgInfoStats);
+        reportFunction("isDuplicateMsg", isDuplicateMsgStats);
+        reportFunction("isInsideROI", isInsideROIStats);
+        reportFunction("createDataMsg", createDataMsgStats);
+    }
+}
+
+void BenchFlooding::deliver(WaveShortMessage* wsm) {
+    Enter_Method_Silent();
+    take(wsm);
+
+    handleLowerMsg(wsm);
+}
+
+void BenchFlooding::extractMsgInfo(WaveShortMessage* wsm, MessageInfoEntry& info) {
+    if (!profileFunctions) {
+        Flooding::extractMsgInfo(wsm, info);
+        return;
+    }
+
+    Clock::time_point start = Clock::now();
+    Flooding::extractMsgInfo(wsm, info);
+    extractMsgInfoStats.nanoseconds += elapsedNanoseconds(start);
+    extractMsgInfoStats.calls++;
+}
+
+bool BenchFlooding::isDuplicateMsg(int64_t key) {
+    if (!profileFunctions)
+        return Flooding::isDuplicateMsg(key);
+
+    Clock::time_point start = Clock::now();
+    bool duplicate = Flooding::isDuplicateMsg(key);
+    isDuplicateMsgStats.nanoseconds += elapsedNanoseconds(start);
+    isDuplicateMsgStats.calls++;
+
+    return duplicate;
+}
+
+bool BenchFlooding::isInsideROI(MessageInfoEntry* info) {
+    if (!profileFunctions)
+        return Flooding::isInsideROI(info);
+
+    Clock::time_point start = Clock::now();
+    bool inside = Flooding::isInsideROI(info);
+    isInsideROIStats.nanoseconds += elapsedNanoseconds(start);
+    isInsideROIStats.calls++;
+
+    return inside;
+}
+
+WaveShortMessage* BenchFlooding::createDataMsg(MessageInfoEntry* info, DataMessage* payload) {
+    if (!profileFunctions)
+        return Flooding::createDataMsg(info, payload);
+
+    Clock::time_point start = Clock::now();
+    WaveShortMessage* wsm = Flooding::createDataMsg(info, payload);
+    createDataMsgStats.nanoseconds += elapsedNanoseconds(start);
+    createDataMsgStats.calls++;
+
+    return wsm;
+}
+
+void BenchFlooding::reportFunction(const char* name, const FunctionStats& stats) {
+    double nsPerCall = stats.calls > 0 ? (double) stats.nanoseconds / stats.calls : 0;
+
+    printf("  %-16s %10ld calls %10.1f ns/call\n", name, stats.calls, nsPerCall);
+
+    std::string prefix(name);
+    recordScalar((prefix + ".calls").c_str(), stats.calls);
+    recordScalar((prefix + ".nsPerCall").c_str(), nsPerCall);
+}
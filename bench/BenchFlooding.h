@@ -0,0 +1,59 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __FLOODING_BENCHFLOODING_H_
+#define __FLOODING_BENCHFLOODING_H_
+
+#include <omnetpp.h>
+#include <stdint.h>
+
+#include "Flooding.h"
+
+// Flooding with an entry point for the benchmark driver, which hands it frames directly instead of through
+// the MAC. If profileFunctions is set, the per-packet helpers are also timed one by one; this adds two clock
+// reads per call, so it should not be combined with the overall ns/message figure.
+class BenchFlooding : public Flooding
+{
+public:
+    // Processes a received frame as if it came from the MAC. Takes ownership of the frame.
+    void deliver(WaveShortMessage* wsm);
+
+protected:
+    struct FunctionStats {
+        long calls;
+        int64_t nanoseconds;
+
+        FunctionStats() : calls(0), nanoseconds(0) {}
+    };
+
+    bool profileFunctions;
+
+    FunctionStats extractMsgInfoStats;
+    FunctionStats isDuplicateMsgStats;
+    FunctionStats isInsideROIStats;
+    FunctionStats createDataMsgStats;
+
+    virtual void initialize(int stage);
+    virtual void finish();
+
+    virtual void extractMsgInfo(WaveShortMessage* wsm, MessageInfoEntry& info);
+    virtual bool isDuplicateMsg(int64_t key);
+    virtual bool isInsideROI(MessageInfoEntry* info);
+    virtual WaveShortMessage* createDataMsg(MessageInfoEntry* info, DataMessage* payload);
+
+    virtual void reportFunction(const char* name, const FunctionStats& stats);
+};
+
+#endif
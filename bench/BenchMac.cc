@@ -0,0 +1,54 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "BenchMac.h"
+
+Define_Module(BenchMac);
+
+void BenchMac::initialize(int stage) {
+    // Mac1609_4::initialize() is not called, it needs a PHY
+    if (stage != 0)
+        return;
+
+    upperLayerIn = findGate("upperLayerIn");
+    upperLayerOut = findGate("upperLayerOut");
+    upperControlIn = findGate("upperControlIn");
+    upperControlOut = findGate("upperControlOut");
+
+    statsReceivedPackets = 0;
+    statsReceivedBroadcasts = 0;
+    statsSentPackets = 0;
+    statsTXRXLostPackets = 0;
+    statsSNIRLostPackets = 0;
+    statsDroppedPackets = 0;
+    statsNumTooLittleTime = 0;
+    statsNumInternalContention = 0;
+    statsNumBackoff = 0;
+    statsSlotsBackoff = 0;
+    statsTotalBusyTime = 0;
+
+    framesFromUpperLayer = 0;
+}
+
+void BenchMac::finish() {
+    recordScalar("framesFromUpperLayer", framesFromUpperLayer);
+}
+
+void BenchMac::handleMessage(cMessage* msg) {
+    if (msg->getArrivalGateId() == upperLayerIn)
+        framesFromUpperLayer++;
+
+    delete msg;
+}
@@ -0,0 +1,42 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __FLOODING_BENCHMAC_H_
+#define __FLOODING_BENCHMAC_H_
+
+#include <omnetpp.h>
+
+#include "Mac1609_4.h"
+
+// Stands in for the 802.11p MAC and PHY of the benchmarked host. Flooding finds it as its Mac1609_4, but
+// nothing is transmitted: the frames handed down are counted and deleted, and the statistics read by Flooding
+// stay at zero.
+class BenchMac : public Mac1609_4
+{
+public:
+    virtual void initialize(int stage);
+    virtual void finish();
+    virtual void handleMessage(cMessage* msg);
+
+    virtual bool isChannelSwitchingActive() { return false; }
+    virtual bool isCurrentChannelCCH() { return true; }
+
+    long getFramesFromUpperLayer() const { return framesFromUpperLayer; }
+
+protected:
+    long framesFromUpperLayer;
+};
+
+#endif
@@ -0,0 +1,167 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "FloodingBenchDriver.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <sys/resource.h>
+
+#include "AllocationCounter.h"
+#include "BaseMobility.h"
+#include "BenchFlooding.h"
+#include "DataMessage_m.h"
+#include "DeciderResult80211.h"
+#include "FindModule.h"
+#include "PhyToMacControlInfo.h"
+
+Define_Module(FloodingBenchDriver);
+
+void FloodingBenchDriver::initialize(int stage) {
+    // The host publishes its position in stage 1
+    if (stage != 1)
+        return;
+
+    cModule* host = getParentModule()->getModuleByPath(par("hostPath").stringValue());
+    if (!host)
+        throw cRuntimeError("FloodingBenchDriver: host %s not found", par("hostPath").stringValue());
+
+    target = FindModule<BenchFlooding*>::findSubModule(host);
+    if (!target)
+        throw cRuntimeError("FloodingBenchDriver: %s has no BenchFlooding application", par("hostPath").stringValue());
+
+    BaseMobility* mobility = FindModule<BaseMobility*>::findSubModule(host);
+    if (!mobility)
+        throw cRuntimeError("FloodingBenchDriver: %s has no mobility module", par("hostPath").stringValue());
+    hostPosition = mobility->getCurrentPosition();
+
+    messages = par("messages").longValue();
+    batchSize = par("batchSize").longValue();
+    batchInterval = par("batchInterval").doubleValue();
+    duplicateRatio = par("duplicateRatio").doubleValue();
+    roiHitRatio = par("roiHitRatio").doubleValue();
+    dataROI = par("dataROI").doubleValue();
+    dataTTL = par("dataTTL").doubleValue();
+    frameLength = par("frameLength").longValue();
+    senderRange = par("senderRange").doubleValue();
+
+    delivered = 0;
+    nextMessageID = 0;
+    nanoseconds = 0;
+    allocations = 0;
+    batch.reserve(batchSize);
+
+    batchTimer = new cMessage("batch");
+    scheduleAt(simTime() + batchInterval, batchTimer);
+}
+
+void FloodingBenchDriver::finish() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    double nsPerMessage = delivered > 0 ? (double) nanoseconds / delivered : 0;
+    double allocationsPerMessage = delivered > 0 ? (double) allocations / delivered : 0;
+    long peakRSS = usage.ru_maxrss; // kB
+
+    printf("FloodingBench: %ld messages (duplicates %.0f%%, inside ROI %.0f%%)\n", delivered, 100 * duplicateRatio,
+            100 * roiHitRatio);
+    printf("  %.1f ns/message, %.2f allocations/message, peak RSS %ld kB\n", nsPerMessage, allocationsPerMessage, peakRSS);
+
+    recordScalar("messages", delivered);
+    recordScalar("nsPerMessage", nsPerMessage);
+    recordScalar("allocationsPerMessage", allocationsPerMessage);
+    recordScalar("peakRSS", peakRSS, "kB");
+}
+
+void FloodingBenchDriver::handleMessage(cMessage* msg) {
+    if (msg != batchTimer) {
+        EV << "FloodingBenchDriver - Error: Got unexpected message! Name: " << msg->getName() << endl;
+        delete msg;
+        return;
+    }
+
+    long count = std::min((long) batchSize, messages - delivered);
+
+    batch.clear();
+    for (long i = 0; i < count; i++)
+        batch.push_back(createFrame());
+
+    uint64_t allocationsBefore = allocationCount();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (std::vector<WaveShortMessage*>::iterator i = batch.begin(); i != batch.end(); i++) {
+        drop(*i);
+        target->deliver(*i);
+    }
+
+    nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    allocations += allocationCount() - allocationsBefore;
+    delivered += count;
+
+    if (delivered < messages) {
+        scheduleAt(simTime() + batchInterval, batchTimer);
+    } else {
+        // Flooding's channel timers would keep the simulation running forever
+        endSimulation();
+    }
+}
+
+WaveShortMessage* FloodingBenchDriver::createFrame() {
+    int messageID;
+    if (nextMessageID > 0 && bernoulli(duplicateRatio)) {
+        // A copy of one of the recent messages, as overheard from another forwarder
+        messageID = std::max(0, nextMessageID - 1 - (int) intuniform(0, batchSize - 1));
+    } else {
+        messageID = nextMessageID++;
+    }
+
+    // The origin of a message must not depend on which copy is delivered, so it is derived from the ID
+    uint32_t hash = (uint32_t) messageID * 2654435761u;
+    double offset = (double) (hash >> 8) / (1 << 24); // in [0, 1)
+    bool insideROI = (hash % 1000) < 1000 * roiHitRatio;
+
+    Coord origin(hostPosition.x + (insideROI ? offset * dataROI / 2 : dataROI * (2 + offset)), hostPosition.y, hostPosition.z);
+
+    WaveShortMessage* wsm = new WaveShortMessage("data");
+    wsm->setSerial(messageID);
+    wsm->setSenderPos(randomPositionAround(hostPosition, 0, senderRange));
+    wsm->setTimestamp(simTime());
+    wsm->setByteLength(frameLength);
+
+    // Read by Flooding when adaptTxPower is set
+    wsm->setControlInfo(new PhyToMacControlInfo(new DeciderResult80211(true, 18e6, uniform(5, 30), uniform(-90, -60))));
+
+    DataMessage* data = new DataMessage("data");
+    data->setMessageOriginPosition(origin);
+    data->setMessageROI(dataROI);
+    data->setMessageOriginTime(simTime());
+    data->setMessageTTL(dataTTL);
+    data->setHops(intuniform(0, 10));
+    wsm->encapsulate(data);
+
+    return wsm;
+}
+
+Coord FloodingBenchDriver::randomPositionAround(const Coord& center, double minDistance, double maxDistance) {
+    double distance = uniform(minDistance, maxDistance);
+    double angle = uniform(0, 2 * M_PI);
+
+    return Coord(center.x + distance * cos(angle), center.y + distance * sin(angle), center.z);
+}
+
+FloodingBenchDriver::~FloodingBenchDriver() {
+    cancelAndDelete(batchTimer);
+}
@@ -0,0 +1,73 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __FLOODING_FLOODINGBENCHDRIVER_H_
+#define __FLOODING_FLOODINGBENCHDRIVER_H_
+
+#include <omnetpp.h>
+#include <stdint.h>
+#include <vector>
+
+#include "Coord.h"
+#include "WaveShortMessage_m.h"
+
+class BenchFlooding;
+
+// Feeds a synthetic stream of data frames to a BenchFlooding and measures the receive/forward path.
+//
+// The frames are built in batches outside of the measured section and then handed to the host one after the
+// other. Only the deliveries are timed, so the figures cover onData and everything it calls (duplicate and ROI
+// checks, logging, building and sending the forwarded frame), but not the MAC or the event loop. Between
+// batches the simulation advances by batchInterval, so the forwarded frames are drained by the MAC.
+class FloodingBenchDriver : public cSimpleModule
+{
+public:
+    virtual int numInitStages() const { return 2; }
+    virtual void initialize(int stage);
+    virtual void finish();
+    virtual void handleMessage(cMessage* msg);
+
+protected:
+    BenchFlooding* target;
+    Coord hostPosition;
+
+    long messages; // Frames to deliver in total
+    int batchSize;
+    simtime_t batchInterval;
+    double duplicateRatio; // Fraction of the frames that repeat a message already delivered
+    double roiHitRatio; // Fraction of the messages whose ROI contains the host
+    double dataROI;
+    simtime_t dataTTL;
+    int frameLength; // bytes
+    double senderRange; // Senders are placed uniformly within this distance of the host
+
+    cMessage* batchTimer;
+
+    long delivered;
+    int nextMessageID;
+    std::vector<WaveShortMessage*> batch;
+
+    int64_t nanoseconds;
+    uint64_t allocations;
+
+    virtual WaveShortMessage* createFrame();
+    virtual Coord randomPositionAround(const Coord& center, double minDistance, double maxDistance);
+
+public:
+    FloodingBenchDriver() : batchTimer(NULL) {}
+    virtual ~FloodingBenchDriver();
+};
+
+#endif
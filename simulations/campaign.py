@@ -0,0 +1,239 @@
+#!/usr/bin/env python3
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this program.  If not, see http://www.gnu.org/licenses/.
+#
+
+"""Runs all the runs of a configuration of omnetpp.ini in parallel.
+
+Every worker owns a TraCI port and its own sumo-launchd.py listening on it, so
+concurrent runs never share a SUMO instance. The runs are expanded by the
+simulation itself (-x <config> -g), failed runs are retried, and the wall time,
+events/sec and peak memory of every run are reported at the end.
+
+Example:
+    ./campaign.py -c Manhattan_1km_x_1km -j 8 --launchd ../../veins/sumo-launchd.py
+"""
+
+import argparse
+import concurrent.futures
+import csv
+import os
+import queue
+import re
+import subprocess
+import sys
+import threading
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+RUN_SCRIPT = os.path.join(HERE, "run")
+
+# Cmdenv reports the last event number when the simulation stops, e.g.
+# "<!> Simulation time limit reached -- simulation stopped at event #123456, t=105."
+EVENT_RE = re.compile(r"event #(\d+)")
+RUN_RE = re.compile(r"^Run (\d+): (.*)$")
+
+
+def list_runs(config):
+    """Returns the (run number, iteration variables) pairs of a configuration."""
+    # -x <config> -g works in both OMNeT++ 4.x and 5.x and prints one "Run <number>: <iteration variables>" line per run
+    out = subprocess.run([RUN_SCRIPT, "-u", "Cmdenv", "-x", config, "-g"],
+                         cwd=HERE, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                         universal_newlines=True, check=True).stdout
+    runs = []
+    for line in out.splitlines():
+        m = RUN_RE.match(line.strip())
+        if m:
+            runs.append((int(m.group(1)), m.group(2).strip()))
+    if not runs:
+        raise RuntimeError("no runs found for configuration %s:\n%s" % (config, out))
+    return runs
+
+
+def parse_run_filter(spec, runs):
+    """Expands a run filter such as "0-9,20" into run numbers."""
+    if not spec:
+        return runs
+    wanted = set()
+    for part in spec.split(","):
+        if "-" in part:
+            first, last = part.split("-")
+            wanted.update(range(int(first), int(last) + 1))
+        else:
+            wanted.add(int(part))
+    return [r for r in runs if r[0] in wanted]
+
+
+class Launchd(object):
+    """A sumo-launchd.py instance serving one worker's port."""
+
+    def __init__(self, script, sumo, port, log_dir):
+        self.port = port
+        self.log = open(os.path.join(log_dir, "launchd-%d.log" % port), "w")
+        self.proc = subprocess.Popen([sys.executable, script, "-vv", "-p", str(port), "-c", sumo],
+                                     stdout=self.log, stderr=subprocess.STDOUT)
+
+    def alive(self):
+        return self.proc.poll() is None
+
+    def stop(self):
+        if self.alive():
+            self.proc.terminate()
+            try:
+                self.proc.wait(timeout=10)
+            except subprocess.TimeoutExpired:
+                self.proc.kill()
+        self.log.close()
+
+
+class Campaign(object):
+    def __init__(self, args):
+        self.args = args
+        self.ports = queue.Queue()
+        self.launchds = {}
+        self.lock = threading.Lock()
+        os.makedirs(args.log_dir, exist_ok=True)
+
+        for slot in range(args.jobs):
+            port = args.base_port + slot
+            if args.launchd:
+                self.launchds[port] = Launchd(args.launchd, args.sumo, port, args.log_dir)
+            self.ports.put(port)
+
+        if args.launchd:
+            # Give the launchers time to bind their ports
+            time.sleep(1)
+
+    def stop(self):
+        for launchd in self.launchds.values():
+            launchd.stop()
+
+    def restart_launchd(self, port):
+        with self.lock:
+            self.launchds[port].stop()
+            self.launchds[port] = Launchd(self.args.launchd, self.args.sumo, port, self.args.log_dir)
+        time.sleep(1)
+
+    def execute(self, run, variables):
+        """Runs one simulation on a free port, retrying on failure. Returns a result dict."""
+        port = self.ports.get()
+        try:
+            for attempt in range(1, self.args.retries + 2):
+                if port in self.launchds and not self.launchds[port].alive():
+                    self.restart_launchd(port)
+
+                log_path = os.path.join(self.args.log_dir, "%s-%d.log" % (self.args.config, run))
+                cmd = [RUN_SCRIPT, "-u", "Cmdenv", "-c", self.args.config, "-r", str(run),
+                       "--VANET.manager.port=%d" % port] + self.args.extra
+
+                start = time.time()
+                with open(log_path, "w") as log:
+                    proc = subprocess.Popen(cmd, cwd=HERE, stdout=log, stderr=subprocess.STDOUT)
+                    # Popen.wait() reaps the child with waitpid, which drops its resource usage, and
+                    # resource.getrusage(RUSAGE_CHILDREN) mixes all the runs of the concurrent workers. wait4 gives the
+                    # peak resident set size of this run alone (the run script and the simulation it starts, in KiB on
+                    # Linux). The child is reaped here, so returncode is set as Popen would, and Popen never waits on it.
+                    _, status, usage = os.wait4(proc.pid, 0)
+                    proc.returncode = os.WEXITSTATUS(status) if os.WIFEXITED(status) else -os.WTERMSIG(status)
+                    rc = proc.returncode
+                wall = time.time() - start
+
+                events = None
+                with open(log_path) as log:
+                    for line in log:
+                        m = EVENT_RE.search(line)
+                        if m:
+                            events = int(m.group(1))
+
+                result = {
+                    "run": run,
+                    "variables": variables,
+                    "port": port,
+                    "attempts": attempt,
+                    "status": "ok" if rc == 0 else "failed (exit code %d)" % rc,
+                    "wall_time": wall,
+                    "events": events,
+                    "events_per_sec": events / wall if events is not None and wall > 0 else None,
+                    "max_rss_mb": usage.ru_maxrss / 1024.0,
+                }
+                if rc == 0:
+                    break
+                print("run %d failed on port %d (attempt %d), see %s" % (run, port, attempt, log_path),
+                      file=sys.stderr)
+            return result
+        finally:
+            self.ports.put(port)
+
+
+def print_report(results):
+    print("%5s  %-40s  %8s  %10s  %12s  %10s  %10s  %s" % ("run", "variables", "attempts", "wall [s]", "events", "ev/s",
+                                                          "RSS [MB]", "status"))
+    for r in results:
+        print("%5d  %-40s  %8d  %10.1f  %12s  %10s  %10.1f  %s" % (
+            r["run"], r["variables"][:40], r["attempts"], r["wall_time"],
+            r["events"] if r["events"] is not None else "-",
+            "%.0f" % r["events_per_sec"] if r["events_per_sec"] is not None else "-",
+            r["max_rss_mb"], r["status"]))
+
+    ok = [r for r in results if r["status"] == "ok"]
+    total_wall = sum(r["wall_time"] for r in results)
+    total_events = sum(r["events"] for r in ok if r["events"] is not None)
+    print()
+    print("%d/%d runs succeeded, %.1f s of simulation wall time, %d events" % (len(ok), len(results), total_wall, total_events))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("-c", "--config", required=True, help="configuration of omnetpp.ini to run")
+    parser.add_argument("-r", "--runs", default="", help="runs to execute, e.g. 0-9,20 (default: all)")
+    parser.add_argument("-j", "--jobs", type=int, default=os.cpu_count() or 1, help="concurrent runs (default: number of cores)")
+    parser.add_argument("--base-port", type=int, default=9999, help="TraCI port of the first worker; worker i uses base-port + i")
+    parser.add_argument("--launchd", default="", help="path to sumo-launchd.py; if empty, a launcher must already listen on every port")
+    parser.add_argument("--sumo", default="sumo", help="SUMO binary started by sumo-launchd.py")
+    parser.add_argument("--retries", type=int, default=2, help="times a failed run is retried")
+    parser.add_argument("--log-dir", default=os.path.join(HERE, "results", "logs"), help="directory for the run logs")
+    parser.add_argument("--report", default="", help="also write the per-run report to this CSV file")
+    parser.add_argument("extra", nargs="*", help="additional arguments for the simulation (after --)")
+    args = parser.parse_args()
+
+    runs = parse_run_filter(args.runs, list_runs(args.config))
+    args.jobs = max(1, min(args.jobs, len(runs)))
+
+    campaign = Campaign(args)
+    results = []
+    try:
+        with concurrent.futures.ThreadPoolExecutor(max_workers=args.jobs) as pool:
+            futures = [pool.submit(campaign.execute, run, variables) for run, variables in runs]
+            for future in concurrent.futures.as_completed(futures):
+                r = future.result()
+                results.append(r)
+                print("run %d: %s in %.1f s" % (r["run"], r["status"], r["wall_time"]))
+    finally:
+        campaign.stop()
+
+    results.sort(key=lambda r: r["run"])
+    print()
+    print_report(results)
+
+    if args.report:
+        with open(args.report, "w", newline="") as f:
+            writer = csv.DictWriter(f, fieldnames=list(results[0].keys()))
+            writer.writeheader()
+            writer.writerows(results)
+
+    return 0 if all(r["status"] == "ok" for r in results) else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
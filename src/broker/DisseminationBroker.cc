@@ -0,0 +1,342 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "DisseminationBroker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+Define_Module(DisseminationBroker);
+
+void DisseminationBroker::initialize() {
+    cellSize = par("cellSize").doubleValue();
+
+    vehiclesInROI = registerSignal("vehiclesInROI");
+    coverage = registerSignal("coverage");
+}
+
+void DisseminationBroker::finish() {
+    // Events still in progress are recorded as they are
+    while (!events.empty()) {
+        Event* event = events.begin()->second;
+
+        if (event->started)
+            retireEvent(event);
+        else {
+            cancelAndDelete(event->timer);
+            delete event;
+            events.erase(events.begin());
+        }
+    }
+
+    if (eventsRetired == 0)
+        return;
+
+    emit(vehiclesInROI, totalInROI);
+    emit(coverage, totalInROI == 0 ? 0.0 : (double) totalCovered / totalInROI);
+}
+
+void DisseminationBroker::handleMessage(cMessage* msg) {
+    if (msg->getKind() == EVENT_END) {
+        endEvent((Event*) msg->getContextPointer());
+    } else if (msg->getKind() == EVENT_RETIRE) {
+        retireEvent((Event*) msg->getContextPointer());
+    } else {
+        EV << "DisseminationBroker - Error: Got unexpected message! Name: " << msg->getName() << endl;
+        delete msg;
+    }
+}
+
+void DisseminationBroker::registerEvent(int eventID, const Coord& origin, double roi, simtime_t startTime, simtime_t ttl) {
+    Enter_Method_Silent();
+
+    if (events.find(eventID) != events.end())
+        throw cRuntimeError("DisseminationBroker: event %d registered twice", eventID);
+
+    Event* event = new Event();
+    event->id = eventID;
+    event->origin = origin;
+    event->roi = roi;
+    event->startTime = startTime;
+    event->ttl = ttl;
+    event->endTime = startTime + ttl;
+    event->started = false;
+    event->active = false;
+    event->closed = false;
+    event->timer = new cMessage("event end", EVENT_END);
+    event->timer->setContextPointer(event);
+
+    events[eventID] = event;
+}
+
+void DisseminationBroker::startEvent(int eventID) {
+    Enter_Method_Silent();
+
+    Event* event = getEvent(eventID);
+
+    if (event->started)
+        return;
+
+    event->startTime = simTime();
+    event->endTime = simTime() + event->ttl;
+
+    buildGrid(event);
+
+    event->started = true;
+    event->active = true;
+    activeEvents.push_back(event);
+    scheduleAt(event->endTime, event->timer);
+
+    // Vehicles inside the ROI when the dissemination starts, from the cells that overlap its bounding box
+    int64_t firstColumn = (int64_t) floor((event->origin.x - event->roi) / cellSize);
+    int64_t lastColumn = (int64_t) floor((event->origin.x + event->roi) / cellSize);
+    int64_t firstRow = (int64_t) floor((event->origin.y - event->roi) / cellSize);
+    int64_t lastRow = (int64_t) floor((event->origin.y + event->roi) / cellSize);
+
+    for (int64_t column = firstColumn; column <= lastColumn; column++) {
+        for (int64_t row = firstRow; row <= lastRow; row++) {
+            std::map<int64_t, std::vector<int> >::iterator cell = vehicleCells.find(cellKey(column, row));
+            if (cell == vehicleCells.end())
+                continue;
+
+            for (std::vector<int>::iterator i = cell->second.begin(); i != cell->second.end(); i++)
+                checkVehicle(event, vehicles[*i].id, vehicles[*i].position);
+        }
+    }
+}
+
+bool DisseminationBroker::closeEvent(int eventID) {
+    Enter_Method_Silent();
+
+    std::map<int, Event*>::iterator e = events.find(eventID);
+    if (e != events.end())
+        e->second->closed = true;
+
+    for (e = events.begin(); e != events.end(); e++) {
+        if (!e->second->closed)
+            return false;
+    }
+
+    return true;
+}
+
+void DisseminationBroker::endEvent(Event* event) {
+    event->active = false;
+    activeEvents.erase(std::find(activeEvents.begin(), activeEvents.end(), event));
+
+    // The membership is decided, only the receptions of the last messages are still to come
+    std::vector<char>().swap(event->cellClass);
+
+    event->timer->setName("event retire");
+    event->timer->setKind(EVENT_RETIRE);
+    scheduleAt(event->endTime + event->ttl, event->timer);
+}
+
+void DisseminationBroker::retireEvent(Event* event) {
+    if (event->active)
+        activeEvents.erase(std::find(activeEvents.begin(), activeEvents.end(), event));
+
+    long covered = 0;
+    for (std::set<int>::iterator i = event->inROI.begin(); i != event->inROI.end(); i++) {
+        if (event->receivers.find(*i) != event->receivers.end())
+            covered++;
+    }
+
+    std::ostringstream prefix;
+    prefix << "event" << event->id << ".";
+    recordScalar((prefix.str() + "vehiclesInROI").c_str(), event->inROI.size());
+    recordScalar((prefix.str() + "coverage").c_str(), event->inROI.empty() ? 0.0 : (double) covered / event->inROI.size());
+
+    eventsRetired++;
+    totalInROI += event->inROI.size();
+    totalCovered += covered;
+
+    events.erase(event->id);
+    cancelAndDelete(event->timer);
+    delete event;
+}
+
+DisseminationBroker::Event* DisseminationBroker::getEvent(int eventID) const {
+    std::map<int, Event*>::const_iterator e = events.find(eventID);
+
+    if (e == events.end())
+        throw cRuntimeError("DisseminationBroker: unknown event %d", eventID);
+
+    return e->second;
+}
+
+simtime_t DisseminationBroker::firstEventNear(const Coord& position, double margin) const {
+    simtime_t first = MAXTIME;
+
+    for (std::map<int, Event*>::const_iterator e = events.begin(); e != events.end(); e++) {
+        const Event* event = e->second;
+        double range = event->roi + margin;
+
+        if (event->started && !event->active)
+            continue;
+
+        if (event->startTime < first && isWithin(event->origin, range, position))
+            first = event->startTime;
+    }
+
+    return first;
+}
+
+void DisseminationBroker::buildGrid(Event* event) {
+    event->minX = event->origin.x - event->roi;
+    event->minY = event->origin.y - event->roi;
+    event->columns = std::max(1, (int) ceil(2 * event->roi / cellSize));
+    event->rows = event->columns;
+
+    event->cellClass.assign(event->columns * event->rows, CELL_BORDER);
+
+    double sqrROI = event->roi * event->roi;
+
+    for (int row = 0; row < event->rows; row++) {
+        for (int column = 0; column < event->columns; column++) {
+            double x0 = event->minX + column * cellSize, x1 = x0 + cellSize;
+            double y0 = event->minY + row * cellSize, y1 = y0 + cellSize;
+
+            // Closest and farthest points of the cell to the origin
+            double nearX = std::max(x0, std::min(event->origin.x, x1)) - event->origin.x;
+            double nearY = std::max(y0, std::min(event->origin.y, y1)) - event->origin.y;
+            double farX = std::max(fabs(x0 - event->origin.x), fabs(x1 - event->origin.x));
+            double farY = std::max(fabs(y0 - event->origin.y), fabs(y1 - event->origin.y));
+
+            char cellClass = CELL_BORDER;
+            if (farX * farX + farY * farY <= sqrROI)
+                cellClass = CELL_INSIDE;
+            else if (nearX * nearX + nearY * nearY > sqrROI)
+                cellClass = CELL_OUTSIDE;
+
+            event->cellClass[row * event->columns + column] = cellClass;
+        }
+    }
+}
+
+void DisseminationBroker::checkVehicle(Event* event, int id, const Coord& position) {
+    int column = (int) floor((position.x - event->minX) / cellSize);
+    int row = (int) floor((position.y - event->minY) / cellSize);
+
+    // Outside the bounding box of the ROI
+    if (column < 0 || row < 0 || column >= event->columns || row >= event->rows)
+        return;
+
+    bool inside = false;
+
+    switch (event->cellClass[row * event->columns + column]) {
+        case CELL_INSIDE:
+            inside = true;
+            break;
+
+        case CELL_BORDER:
+            inside = isWithin(event->origin, event->roi, position);
+            break;
+
+        default:
+            break;
+    }
+
+    if (inside) {
+        event->inROI.insert(id);
+        inAnyROI.insert(id);
+    }
+}
+
+int64_t DisseminationBroker::cellKey(int64_t column, int64_t row) const {
+    return (int64_t) (((uint64_t) column << 32) | (uint32_t) row);
+}
+
+int64_t DisseminationBroker::cellOf(const Coord& position) const {
+    return cellKey((int64_t) floor(position.x / cellSize), (int64_t) floor(position.y / cellSize));
+}
+
+void DisseminationBroker::addToCell(int handle, int64_t cell) {
+    std::vector<int>& bucket = vehicleCells[cell];
+
+    vehicles[handle].cell = cell;
+    vehicles[handle].indexInCell = bucket.size();
+    bucket.push_back(handle);
+}
+
+void DisseminationBroker::removeFromCell(int handle) {
+    std::vector<int>& bucket = vehicleCells[vehicles[handle].cell];
+    int index = vehicles[handle].indexInCell;
+
+    // The last vehicle of the bucket takes the free place
+    bucket[index] = bucket.back();
+    vehicles[bucket[index]].indexInCell = index;
+    bucket.pop_back();
+}
+
+int DisseminationBroker::addVehicle(int id, const Coord& position) {
+    Enter_Method_Silent();
+
+    int handle;
+    if (freeHandles.empty()) {
+        handle = vehicles.size();
+        vehicles.push_back(Vehicle());
+    } else {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+    }
+
+    vehicles[handle].id = id;
+    vehicles[handle].position = position;
+    addToCell(handle, cellOf(position));
+
+    for (std::vector<Event*>::iterator e = activeEvents.begin(); e != activeEvents.end(); e++)
+        checkVehicle(*e, id, position);
+
+    return handle;
+}
+
+void DisseminationBroker::updateVehicle(int handle, const Coord& position) {
+    Vehicle& vehicle = vehicles[handle];
+    vehicle.position = position;
+
+    int64_t cell = cellOf(position);
+    if (cell != vehicle.cell) {
+        removeFromCell(handle);
+        addToCell(handle, cell);
+    }
+
+    for (std::vector<Event*>::iterator e = activeEvents.begin(); e != activeEvents.end(); e++)
+        checkVehicle(*e, vehicle.id, position);
+}
+
+void DisseminationBroker::removeVehicle(int handle) {
+    Enter_Method_Silent();
+
+    removeFromCell(handle);
+    vehicles[handle].indexInCell = -1;
+    freeHandles.push_back(handle);
+}
+
+void DisseminationBroker::reportReception(int eventID, int id) {
+    std::map<int, Event*>::iterator e = events.find(eventID);
+
+    // Late copies of a retired event no longer count
+    if (e != events.end())
+        e->second->receivers.insert(id);
+}
+
+DisseminationBroker::~DisseminationBroker() {
+    for (std::map<int, Event*>::iterator e = events.begin(); e != events.end(); e++) {
+        cancelAndDelete(e->second->timer);
+        delete e->second;
+    }
+}
@@ -0,0 +1,165 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __FLOODING_DISSEMINATIONBROKER_H_
+#define __FLOODING_DISSEMINATIONBROKER_H_
+
+#include <omnetpp.h>
+#include <map>
+#include <set>
+#include <stdint.h>
+#include <vector>
+
+#include "Coord.h"
+
+// Single owner of the metadata of the dissemination events and of the ROI membership of the vehicles.
+//
+// Every RSU registers its event, identified by an event ID, when it initializes, and starts it when it sends
+// the first packet. Vehicles report their position on every mobility update. The positions are bucketed in a
+// uniform grid of cells of cellSize, so an update only stores the position and moves the vehicle to another
+// bucket when it crosses a cell border, and the vehicles inside the ROI when an event starts are found in the
+// cells around its origin instead of among all the vehicles. While an event is active (from its start to
+// start + TTL), the broker marks the vehicles that are inside its ROI. A second grid is laid over the bounding
+// box of every active ROI: cells completely inside or completely outside the ROI decide the membership of their
+// vehicles directly, and only vehicles in cells crossed by the ROI border are checked against the ROI radius.
+// The ROI is a disc on the ground plane.
+//
+// Receptions are still accepted for one more TTL after the event ends, since the last messages can live that long.
+// Then the coverage of the event is recorded and its state is released, so the memory used depends on the events
+// in progress, not on all the events of the run.
+class DisseminationBroker : public cSimpleModule
+{
+public:
+    // Called by the RSU when it initializes, before the event starts
+    void registerEvent(int eventID, const Coord& origin, double roi, simtime_t startTime, simtime_t ttl);
+
+    // Called by the RSU when it sends the first packet of the event
+    void startEvent(int eventID);
+
+    // Called by the RSU at the end of its dissemination. Returns true if all the registered events are closed.
+    bool closeEvent(int eventID);
+
+    // Called by a vehicle with its first position. Returns the handle of the vehicle for the calls below.
+    int addVehicle(int id, const Coord& position);
+    void updateVehicle(int handle, const Coord& position);
+    void removeVehicle(int handle);
+
+    // Called by a vehicle when it accepts its first message of an event
+    void reportReception(int eventID, int id);
+
+    // Whether the vehicle was inside the ROI of some event at some point while that event was active
+    bool wasInROI(int id) const { return inAnyROI.find(id) != inAnyROI.end(); }
+
+    // Earliest planned start of the events that are not over and whose ROI, enlarged by margin, contains
+    // position. MAXTIME if there is none.
+    simtime_t firstEventNear(const Coord& position, double margin) const;
+
+    // Whether position is within range of origin. The ROI is a disc on the ground plane, so the height is ignored.
+    // The broker and the vehicles use this same test, so they never disagree on the membership of a vehicle.
+    static bool isWithin(const Coord& origin, double range, const Coord& position) {
+        return position.sqrTwoDimDist(origin) <= range * range;
+    }
+
+protected:
+    enum {
+        EVENT_END = 1,
+        EVENT_RETIRE,
+    };
+
+    enum CellClass {
+        CELL_OUTSIDE,
+        CELL_INSIDE,
+        CELL_BORDER,
+    };
+
+    struct Event {
+        int id;
+        Coord origin;
+        double roi;
+        simtime_t startTime; // Planned until the event starts
+        simtime_t ttl;
+        simtime_t endTime;
+        bool started;
+        bool active;
+        bool closed;
+
+        // Grid laid over the bounding box of the ROI, only kept while the event is active
+        double minX, minY;
+        int columns, rows;
+        std::vector<char> cellClass;
+
+        // Vehicles that were inside the ROI while the event was active
+        std::set<int> inROI;
+
+        // Vehicles that received at least one message of the event
+        std::set<int> receivers;
+
+        // Ends the event, then retires it
+        cMessage* timer;
+    };
+
+    double cellSize;
+
+    // Events registered and not retired yet, by event ID
+    std::map<int, Event*> events;
+
+    // Active events, checked on every vehicle update
+    std::vector<Event*> activeEvents;
+
+    struct Vehicle {
+        int id;
+        Coord position; // Last reported position
+        int64_t cell;
+        int indexInCell; // Index in the bucket of its cell, -1 if the handle is free
+    };
+
+    // Reported vehicles, by handle. The handles of the removed vehicles are reused.
+    std::vector<Vehicle> vehicles;
+    std::vector<int> freeHandles;
+
+    // Handles of the vehicles in every cell that ever had one, by cell key
+    std::map<int64_t, std::vector<int> > vehicleCells;
+
+    // Vehicles that were inside the ROI of at least one event
+    std::set<int> inAnyROI;
+
+    // Events retired so far, and their total of vehicles in ROI and of covered vehicles
+    long eventsRetired;
+    long totalInROI;
+    long totalCovered;
+
+    simsignal_t vehiclesInROI;
+    simsignal_t coverage;
+
+    virtual void initialize();
+    virtual void finish();
+    virtual void handleMessage(cMessage* msg);
+
+    virtual Event* getEvent(int eventID) const;
+    virtual void buildGrid(Event* event);
+    virtual void checkVehicle(Event* event, int id, const Coord& position);
+    virtual int64_t cellKey(int64_t column, int64_t row) const;
+    virtual int64_t cellOf(const Coord& position) const;
+    virtual void addToCell(int handle, int64_t cell);
+    virtual void removeFromCell(int handle);
+    virtual void endEvent(Event* event);
+    virtual void retireEvent(Event* event);
+
+public:
+    DisseminationBroker() : eventsRetired(0), totalInROI(0), totalCovered(0) {}
+    virtual ~DisseminationBroker();
+};
+
+#endif
@@ -0,0 +1,56 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "ChannelIntervalClock.h"
+
+#include "Consts80211p.h"
+
+Define_Module(ChannelIntervalClock);
+
+const simsignalwrap_t ChannelIntervalClock::intervalStartSignal = simsignalwrap_t("channelIntervalStart");
+
+void ChannelIntervalClock::initialize() {
+    intervalTimer = new cMessage("channel interval start", INTERVAL_START);
+
+    uint64_t currentTime = simTime().raw();
+    uint64_t switchingTime = SWITCHING_INTERVAL_11P.raw();
+
+    SimTime nextSwitch;
+    nextSwitch.setRaw(currentTime - currentTime % switchingTime + switchingTime);
+    scheduleAt(nextSwitch, intervalTimer);
+}
+
+void ChannelIntervalClock::handleMessage(cMessage* msg) {
+    if (msg != intervalTimer) {
+        EV << "ChannelIntervalClock - Error: Got unexpected message! Name: " << msg->getName() << endl;
+        delete msg;
+        return;
+    }
+
+    emit(intervalStartSignal, (long) currentInterval());
+
+    scheduleAt(simTime() + SWITCHING_INTERVAL_11P, intervalTimer);
+}
+
+ChannelIntervalClock::Interval ChannelIntervalClock::currentInterval() {
+    uint64_t currentTime = simTime().raw();
+    uint64_t switchingTime = SWITCHING_INTERVAL_11P.raw();
+
+    return (currentTime / switchingTime) % 2 == 0 ? CCH_INTERVAL : SCH_INTERVAL;
+}
+
+ChannelIntervalClock::~ChannelIntervalClock() {
+    cancelAndDelete(intervalTimer);
+}
@@ -0,0 +1,55 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __FLOODING_CHANNELINTERVALCLOCK_H_
+#define __FLOODING_CHANNELINTERVALCLOCK_H_
+
+#include <omnetpp.h>
+
+#include "MiXiMDefs.h"
+
+// Single source of the IEEE 1609.4 channel interval boundaries for the whole network. Instead of every host
+// scheduling its own CCH and SCH start timers, the hosts subscribe to intervalStartSignal on this module and get
+// a callback at every boundary, so the event queue holds two events per sync interval regardless of the number
+// of hosts. The value of the signal is the interval that starts (CCH_INTERVAL or SCH_INTERVAL).
+class ChannelIntervalClock : public cSimpleModule
+{
+public:
+    enum Interval {
+        CCH_INTERVAL,
+        SCH_INTERVAL,
+    };
+
+    static const simsignalwrap_t intervalStartSignal;
+
+    virtual void initialize();
+    virtual void handleMessage(cMessage* msg);
+
+    // Interval active at the current simulation time
+    static Interval currentInterval();
+
+protected:
+    enum {
+        INTERVAL_START = 1,
+    };
+
+    cMessage* intervalTimer;
+
+public:
+    ChannelIntervalClock() : intervalTimer(NULL) {}
+    virtual ~ChannelIntervalClock();
+};
+
+#endif
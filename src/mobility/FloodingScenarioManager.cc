@@ -0,0 +1,71 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "FloodingScenarioManager.h"
+
+#include <algorithm>
+
+Define_Module(FloodingScenarioManager);
+
+void FloodingScenarioManager::initialize(int stage) {
+    if (stage == 0) {
+        fastForward = par("fastForward").boolValue();
+
+        if (fastForward) {
+            cModule* rsu = getParentModule()->getSubmodule("rsu", 0);
+            if (!rsu)
+                throw cRuntimeError("FloodingScenarioManager: fast-forward needs the RSUs of the events");
+
+            double firstEvent = -1;
+            for (int i = 0; i < rsu->getVectorSize(); i++) {
+                rsus.push_back(getParentModule()->getSubmodule("rsu", i));
+
+                double start = rsus.back()->getSubmodule("appl")->par("startDataProductionTime").doubleValue();
+                if (firstEvent < 0 || start < firstEvent)
+                    firstEvent = start;
+            }
+
+            // Let SUMO run alone until shortly before the first event. Must be set before the base class reads it.
+            double firstStep = firstEvent - par("warmupTime").doubleValue();
+            par("firstStepAt").setDoubleValue(std::max(0.0, firstStep));
+        }
+    }
+
+    Veins::TraCIScenarioManagerLaunchd::initialize(stage);
+}
+
+void FloodingScenarioManager::init_traci() {
+    Veins::TraCIScenarioManagerLaunchd::init_traci();
+
+    if (!fastForward)
+        return;
+
+    for (std::vector<cModule*>::iterator i = rsus.begin(); i != rsus.end(); i++) {
+        cModule* mobility = (*i)->getSubmodule("mobility");
+        double halfSide = (*i)->getSubmodule("appl")->par("dataROI").doubleValue() + par("roiMargin").doubleValue();
+        Coord origin(mobility->par("x").doubleValue(), mobility->par("y").doubleValue());
+
+        // roiRects are in SUMO coordinates, whose y axis is flipped with respect to OMNeT++
+        Veins::TraCICoord a = connection->omnet2traci(Coord(origin.x - halfSide, origin.y - halfSide));
+        Veins::TraCICoord b = connection->omnet2traci(Coord(origin.x + halfSide, origin.y + halfSide));
+
+        Veins::TraCICoord first(std::min(a.x, b.x), std::min(a.y, b.y));
+        Veins::TraCICoord second(std::max(a.x, b.x), std::max(a.y, b.y));
+        roiRects.push_back(std::pair<Veins::TraCICoord, Veins::TraCICoord>(first, second));
+
+        EV << "FloodingScenarioManager: fast-forward to " << par("firstStepAt").doubleValue() << "s, region of interest "
+                << first.x << "," << first.y << "-" << second.x << "," << second.y << endl;
+    }
+}
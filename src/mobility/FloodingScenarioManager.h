@@ -0,0 +1,42 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __FLOODING_FLOODINGSCENARIOMANAGER_H_
+#define __FLOODING_FLOODINGSCENARIOMANAGER_H_
+
+#include <vector>
+
+#include "TraCIScenarioManagerLaunchd.h"
+
+// TraCIScenarioManagerLaunchd that can fast-forward long traces. When fastForward is set, the first simulation
+// step is moved to warmupTime before the first event and the region of interest is derived from the origin and
+// dataROI of every event, so that only the vehicles near an event are instantiated and only shortly before it.
+// The events are read from the RSUs, so they cannot differ from the disseminations that are simulated.
+class FloodingScenarioManager : public Veins::TraCIScenarioManagerLaunchd
+{
+public:
+    virtual void initialize(int stage);
+
+protected:
+    bool fastForward;
+
+    // RSU modules of the network, each disseminating one event
+    std::vector<cModule*> rsus;
+
+    // Adds the region around every event to roiRects once the network boundaries are known
+    virtual void init_traci();
+};
+
+#endif
@@ -0,0 +1,164 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "GridScenarioManager.h"
+
+#include <cmath>
+#include <sstream>
+
+Define_Module(GridScenarioManager);
+
+void GridScenarioManager::initialize(int stage) {
+    LocalScenarioManager::initialize(stage);
+
+    if (stage != 1)
+        return;
+
+    numVehicles = par("numVehicles").longValue();
+    columns = par("columns").longValue();
+    rows = par("rows").longValue();
+    blockLength = par("blockLength").doubleValue();
+    margin = par("margin").doubleValue();
+    turnProbability = par("turnProbability").doubleValue();
+
+    if (numVehicles < 0)
+        throw cRuntimeError("GridScenarioManager: numVehicles must not be negative, got %d", numVehicles);
+    if (columns < 1 || rows < 1 || (columns == 1 && rows == 1))
+        throw cRuntimeError("GridScenarioManager: the grid needs at least two intersections, got %d x %d", columns, rows);
+    if (blockLength <= 0)
+        throw cRuntimeError("GridScenarioManager: blockLength must be positive");
+
+    stepTimer = new cMessage("grid step", GRID_STEP);
+    scheduleAt(std::max(simTime(), SimTime(par("startTime").doubleValue())), stepTimer);
+}
+
+void GridScenarioManager::finish() {
+    LocalScenarioManager::finish();
+
+    recordScalar("gridVehicles", vehicles.size());
+    recordScalar("gridMobilityUpdates", mobilityUpdates);
+}
+
+void GridScenarioManager::handleMessage(cMessage* msg) {
+    if (msg != stepTimer) {
+        EV << "GridScenarioManager - Error: Got unexpected message! Name: " << msg->getName() << endl;
+        delete msg;
+        return;
+    }
+
+    if (!inserted) {
+        insertVehicles();
+        inserted = true;
+    } else {
+        double elapsed = (simTime() - lastStep).dbl();
+
+        for (std::vector<Vehicle>::iterator i = vehicles.begin(); i != vehicles.end(); i++) {
+            advance(*i, i->speed * elapsed);
+            moveVehicle(i->index, positionOf(*i), i->speed, angleOf(*i));
+        }
+
+        mobilityUpdates += vehicles.size();
+    }
+
+    lastStep = simTime();
+    scheduleAt(simTime() + updateInterval, stepTimer);
+}
+
+void GridScenarioManager::insertVehicles() {
+    double rowLength = (columns - 1) * blockLength;
+    double columnLength = (rows - 1) * blockLength;
+
+    vehicles.resize(numVehicles);
+
+    for (int i = 0; i < numVehicles; i++) {
+        Vehicle& vehicle = vehicles[i];
+        vehicle.index = i;
+
+        // Every meter of street is equally likely
+        vehicle.horizontal = uniform(0, rows * rowLength + columns * columnLength) < rows * rowLength;
+        vehicle.street = intuniform(0, (vehicle.horizontal ? rows : columns) - 1);
+        vehicle.offset = uniform(0, vehicle.horizontal ? rowLength : columnLength);
+        vehicle.direction = bernoulli(0.5) ? 1 : -1;
+        vehicle.speed = par("speed").doubleValue();
+
+        std::ostringstream externalId;
+        externalId << "grid." << i;
+
+        addVehicle(i, externalId.str(), positionOf(vehicle), vehicle.speed, angleOf(vehicle));
+    }
+}
+
+void GridScenarioManager::advance(Vehicle& vehicle, double distance) {
+    while (distance > 0) {
+        // Intersections are at whole multiples of blockLength along the street. The offset is set to exactly
+        // that multiple when one is reached, so the next one is found without rounding problems.
+        double position = vehicle.offset / blockLength;
+        int next = vehicle.direction > 0 ? (int) std::floor(position) + 1 : (int) std::ceil(position) - 1;
+        double toNext = std::fabs(next * blockLength - vehicle.offset);
+
+        if (distance < toNext) {
+            vehicle.offset += vehicle.direction * distance;
+            return;
+        }
+
+        distance -= toNext;
+        vehicle.offset = next * blockLength;
+        turn(vehicle, next);
+    }
+}
+
+void GridScenarioManager::turn(Vehicle& vehicle, int intersection) {
+    int alongLength = vehicle.horizontal ? columns : rows; // Intersections on the current street
+    int crossLength = vehicle.horizontal ? rows : columns; // Intersections on the crossing street
+
+    bool canGoStraight = intersection + vehicle.direction >= 0 && intersection + vehicle.direction < alongLength;
+    bool canTurnUp = vehicle.street + 1 < crossLength;
+    bool canTurnDown = vehicle.street > 0;
+
+    if (canGoStraight && !(canTurnUp || canTurnDown))
+        return;
+
+    if ((canTurnUp || canTurnDown) && (!canGoStraight || bernoulli(turnProbability))) {
+        // Left or right, whichever exists, at random if both do
+        int crossDirection = canTurnUp && (!canTurnDown || bernoulli(0.5)) ? 1 : -1;
+
+        vehicle.offset = vehicle.street * blockLength;
+        vehicle.street = intersection;
+        vehicle.horizontal = !vehicle.horizontal;
+        vehicle.direction = crossDirection;
+    } else if (!canGoStraight) {
+        // Dead end of a grid with a single row or column
+        vehicle.direction = -vehicle.direction;
+    }
+}
+
+Coord GridScenarioManager::positionOf(const Vehicle& vehicle) const {
+    double along = margin + vehicle.offset;
+    double across = margin + vehicle.street * blockLength;
+
+    return vehicle.horizontal ? Coord(along, across, 0) : Coord(across, along, 0);
+}
+
+double GridScenarioManager::angleOf(const Vehicle& vehicle) const {
+    // Same convention as TraCIMobility: counterclockwise from the x axis, with the y axis pointing down
+    double dx = vehicle.horizontal ? vehicle.direction : 0;
+    double dy = vehicle.horizontal ? 0 : vehicle.direction;
+
+    return std::atan2(-dy, dx);
+}
+
+GridScenarioManager::~GridScenarioManager() {
+    cancelAndDelete(stepTimer);
+}
@@ -0,0 +1,77 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __FLOODING_GRIDSCENARIOMANAGER_H_
+#define __FLOODING_GRIDSCENARIOMANAGER_H_
+
+#include <vector>
+
+#include "LocalScenarioManager.h"
+
+// Generates Manhattan-grid mobility without SUMO. The streets form a grid of columns x rows intersections
+// blockLength apart, starting margin away from the playground origin. numVehicles vehicles are placed at
+// random on the streets at startTime and then driven from a single timer every updateInterval: each one moves
+// at its own speed along its street and, at every intersection, turns left or right with probability
+// turnProbability and goes straight otherwise, turning back only at a dead end. The vehicles never leave the
+// grid, so the population is constant for the whole run.
+class GridScenarioManager : public LocalScenarioManager
+{
+public:
+    virtual void initialize(int stage);
+    virtual void finish();
+    virtual void handleMessage(cMessage* msg);
+
+protected:
+    enum {
+        GRID_STEP = 1,
+    };
+
+    struct Vehicle {
+        int index;
+        bool horizontal; // Driving along a row (x axis) or a column (y axis)
+        int street; // Row or column the vehicle is on
+        double offset; // Distance from the first intersection of the street, in m
+        int direction; // +1 or -1 along the street
+        double speed; // m/s
+    };
+
+    int numVehicles;
+    int columns;
+    int rows;
+    double blockLength;
+    double margin;
+    double turnProbability;
+
+    std::vector<Vehicle> vehicles;
+    bool inserted; // Whether the vehicles were inserted at the first step
+
+    cMessage* stepTimer;
+    simtime_t lastStep;
+
+    long mobilityUpdates;
+
+    virtual void insertVehicles();
+    virtual void advance(Vehicle& vehicle, double distance);
+    virtual void turn(Vehicle& vehicle, int intersection);
+
+    virtual Coord positionOf(const Vehicle& vehicle) const;
+    virtual double angleOf(const Vehicle& vehicle) const;
+
+public:
+    GridScenarioManager() : inserted(false), stepTimer(NULL), mobilityUpdates(0) {}
+    virtual ~GridScenarioManager();
+};
+
+#endif
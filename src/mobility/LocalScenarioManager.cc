@@ -0,0 +1,86 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "LocalScenarioManager.h"
+
+#include "FindModule.h"
+#include "TraCIMobility.h"
+#include "veins/base/connectionManager/BaseConnectionManager.h"
+
+void LocalScenarioManager::initialize(int stage) {
+    if (stage != 1)
+        return;
+
+    moduleType = par("moduleType").stdstringValue();
+    moduleName = par("moduleName").stdstringValue();
+    moduleDisplayString = par("moduleDisplayString").stdstringValue();
+    updateInterval = par("updateInterval").doubleValue();
+
+    connectionManager = FindModule<BaseConnectionManager*>::findGlobalModule();
+    if (!connectionManager)
+        throw cRuntimeError("LocalScenarioManager: could not find a connection manager module");
+}
+
+void LocalScenarioManager::finish() {
+    while (!hosts.empty())
+        removeVehicle(hosts.begin()->first);
+}
+
+cModule* LocalScenarioManager::addVehicle(int index, const std::string& externalId, const Coord& position, double speed,
+        double angle) {
+    if (hosts.find(index) != hosts.end())
+        throw cRuntimeError("LocalScenarioManager: vehicle %d added twice", index);
+
+    cModuleType* nodeType = cModuleType::get(moduleType.c_str());
+    if (!nodeType)
+        throw cRuntimeError("LocalScenarioManager: module type \"%s\" not found", moduleType.c_str());
+
+    cModule* mod = nodeType->create(moduleName.c_str(), getParentModule(), index + 1, index);
+    mod->finalizeParameters();
+    mod->getDisplayString().parse(moduleDisplayString.c_str());
+    mod->buildInside();
+    mod->scheduleStart(simTime() + updateInterval);
+
+    Veins::TraCIMobilityAccess().get(mod)->preInitialize(externalId, position, "", speed, angle);
+
+    mod->callInitialize();
+    hosts[index] = mod;
+
+    return mod;
+}
+
+void LocalScenarioManager::moveVehicle(int index, const Coord& position, double speed, double angle) {
+    cModule* mod = getVehicle(index);
+    if (!mod)
+        return;
+
+    Veins::TraCIMobilityAccess().get(mod)->nextPosition(position, "", speed, angle);
+}
+
+void LocalScenarioManager::removeVehicle(int index) {
+    cModule* mod = getVehicle(index);
+    if (!mod)
+        return;
+
+    connectionManager->unregisterNic(mod->getSubmodule("nic"));
+    hosts.erase(index);
+    mod->callFinish();
+    mod->deleteModule();
+}
+
+cModule* LocalScenarioManager::getVehicle(int index) const {
+    std::map<int, cModule*>::const_iterator i = hosts.find(index);
+    return i == hosts.end() ? NULL : i->second;
+}
@@ -0,0 +1,58 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __FLOODING_LOCALSCENARIOMANAGER_H_
+#define __FLOODING_LOCALSCENARIOMANAGER_H_
+
+#include <omnetpp.h>
+#include <map>
+#include <string>
+
+#include "Coord.h"
+
+class BaseConnectionManager;
+
+// Base class of the scenario managers that drive the vehicles without SUMO.
+//
+// The host modules are created, moved and deleted the same way TraCIScenarioManager does it: every host gets
+// a TraCIMobility that is pre-initialized with its first position and then fed with nextPosition(), so the
+// applications cannot tell the difference. Subclasses decide when and where the vehicles appear and move.
+class LocalScenarioManager : public cSimpleModule
+{
+public:
+    virtual int numInitStages() const { return 2; }
+    virtual void initialize(int stage);
+    virtual void finish();
+
+protected:
+    std::string moduleType;
+    std::string moduleName;
+    std::string moduleDisplayString;
+    simtime_t updateInterval;
+
+    BaseConnectionManager* connectionManager;
+
+    // Host modules by their vector index
+    std::map<int, cModule*> hosts;
+
+    // Creates host moduleName[index]. The position is in OMNeT++ coordinates and the angle in rad.
+    virtual cModule* addVehicle(int index, const std::string& externalId, const Coord& position, double speed, double angle);
+    virtual void moveVehicle(int index, const Coord& position, double speed, double angle);
+    virtual void removeVehicle(int index);
+
+    cModule* getVehicle(int index) const;
+};
+
+#endif
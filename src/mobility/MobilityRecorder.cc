@@ -0,0 +1,145 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "MobilityRecorder.h"
+
+#include <cstring>
+
+#include "TraCIMobility.h"
+
+Define_Module(MobilityRecorder);
+
+const simsignalwrap_t MobilityRecorder::mobilityStateChangedSignal = simsignalwrap_t(MIXIM_SIGNAL_MOBILITY_CHANGE_NAME);
+
+void MobilityRecorder::initialize() {
+    std::string fileName = par("recordFile").stdstringValue();
+
+    if (fileName.empty())
+        return;
+
+    file = fopen(fileName.c_str(), "wb");
+    if (!file)
+        throw cRuntimeError("MobilityRecorder: cannot open trace file %s", fileName.c_str());
+
+    MobilityTraceFormat::FileHeader header;
+    memcpy(header.magic, MobilityTraceFormat::MAGIC, sizeof(header.magic));
+    header.version = MobilityTraceFormat::VERSION;
+    header.timeScaleExp = SimTime::getScaleExp();
+    fwrite(&header, sizeof(header), 1, file);
+
+    cModule* network = getSimulation()->getSystemModule();
+    network->subscribe(mobilityStateChangedSignal, this);
+    network->subscribe(PRE_MODEL_CHANGE, this);
+}
+
+void MobilityRecorder::finish() {
+    if (!file)
+        return;
+
+    cModule* network = getSimulation()->getSystemModule();
+    network->unsubscribe(mobilityStateChangedSignal, this);
+    network->unsubscribe(PRE_MODEL_CHANGE, this);
+
+    writeHeader(MobilityTraceFormat::TRACE_END, 0);
+
+    recordScalar("mobilityRecords", recordsWritten);
+
+    close();
+}
+
+void MobilityRecorder::handleMessage(cMessage* msg) {
+    EV << "MobilityRecorder - Error: Got unexpected message! Name: " << msg->getName() << endl;
+    delete msg;
+}
+
+void MobilityRecorder::receiveSignal(cComponent* source, simsignal_t signalID, cObject* obj, cObject* details) {
+    if (!file)
+        return;
+
+    if (signalID == mobilityStateChangedSignal) {
+        // RSUs and other statically placed nodes do not use TraCIMobility
+        Veins::TraCIMobility* mobility = dynamic_cast<Veins::TraCIMobility*>(source);
+        if (mobility)
+            recordPosition(mobility);
+    } else if (signalID == PRE_MODEL_CHANGE) {
+        cPreModuleDeleteNotification* notification = dynamic_cast<cPreModuleDeleteNotification*>(obj);
+        if (!notification)
+            return;
+
+        std::map<int, int>::iterator i = vehicles.find(notification->module->getId());
+        if (i != vehicles.end()) {
+            writeHeader(MobilityTraceFormat::VEHICLE_REMOVE, i->second);
+            vehicles.erase(i);
+        }
+    }
+}
+
+void MobilityRecorder::recordPosition(Veins::TraCIMobility* mobility) {
+    cModule* host = mobility->getParentModule();
+    std::map<int, int>::iterator i = vehicles.find(host->getId());
+
+    if (i == vehicles.end()) {
+        // The first update is emitted while the scenario manager initializes the new host
+        int vehicle = host->getIndex();
+        vehicles[host->getId()] = vehicle;
+
+        std::string externalId = mobility->getExternalId();
+        uint16_t length = externalId.size();
+
+        writeHeader(MobilityTraceFormat::VEHICLE_ADD, vehicle);
+        fwrite(&length, sizeof(length), 1, file);
+        fwrite(externalId.data(), 1, length, file);
+    } else {
+        writeHeader(MobilityTraceFormat::VEHICLE_MOVE, i->second);
+    }
+
+    writePosition(mobility);
+}
+
+void MobilityRecorder::writeHeader(MobilityTraceFormat::RecordType type, int vehicle) {
+    uint8_t recordType = type;
+    int64_t time = simTime().raw();
+    uint32_t number = vehicle;
+
+    fwrite(&recordType, sizeof(recordType), 1, file);
+    fwrite(&time, sizeof(time), 1, file);
+    fwrite(&number, sizeof(number), 1, file);
+
+    recordsWritten++;
+}
+
+void MobilityRecorder::writePosition(Veins::TraCIMobility* mobility) {
+    Coord position = mobility->getCurrentPosition();
+
+    MobilityTraceFormat::Position p;
+    p.x = position.x;
+    p.y = position.y;
+    p.z = position.z;
+    p.speed = mobility->getSpeed();
+    p.angle = mobility->getAngleRad();
+
+    fwrite(&p, sizeof(p), 1, file);
+}
+
+void MobilityRecorder::close() {
+    if (file) {
+        fclose(file);
+        file = NULL;
+    }
+}
+
+MobilityRecorder::~MobilityRecorder() {
+    close();
+}
@@ -0,0 +1,64 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __FLOODING_MOBILITYRECORDER_H_
+#define __FLOODING_MOBILITYRECORDER_H_
+
+#include <omnetpp.h>
+#include <cstdio>
+#include <map>
+#include <string>
+
+#include "MiXiMDefs.h"
+#include "MobilityTraceFormat.h"
+
+namespace Veins {
+class TraCIMobility;
+}
+
+// Writes the mobility of the TraCI-driven vehicles to a trace that ReplayScenarioManager can play back without
+// SUMO. Listens at the network level for the mobility updates of every TraCIMobility and for the deletion of
+// the hosts, so nothing has to change in the scenario manager or in the hosts. Disabled if recordFile is empty.
+class MobilityRecorder : public cSimpleModule, public cListener
+{
+public:
+    virtual void initialize();
+    virtual void finish();
+    virtual void handleMessage(cMessage* msg);
+
+    using cListener::receiveSignal;
+    virtual void receiveSignal(cComponent* source, simsignal_t signalID, cObject* obj, cObject* details);
+
+protected:
+    static const simsignalwrap_t mobilityStateChangedSignal;
+
+    FILE* file;
+
+    // Vector index of the hosts being recorded, by module id of the host
+    std::map<int, int> vehicles;
+
+    long recordsWritten;
+
+    virtual void recordPosition(Veins::TraCIMobility* mobility);
+    virtual void writeHeader(MobilityTraceFormat::RecordType type, int vehicle);
+    virtual void writePosition(Veins::TraCIMobility* mobility);
+    virtual void close();
+
+public:
+    MobilityRecorder() : file(NULL), recordsWritten(0) {}
+    virtual ~MobilityRecorder();
+};
+
+#endif
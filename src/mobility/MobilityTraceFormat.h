@@ -0,0 +1,61 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __FLOODING_MOBILITYTRACEFORMAT_H_
+#define __FLOODING_MOBILITYTRACEFORMAT_H_
+
+#include <stdint.h>
+
+// Layout of the mobility traces written by MobilityRecorder and read by ReplayScenarioManager.
+//
+// The file starts with a FileHeader followed by records in time order. Every record starts with
+//
+//     uint8_t  type          RecordType
+//     int64_t  time          raw simulation time in 10^timeScaleExp s
+//     uint32_t vehicle       number of the vehicle, unique within the trace
+//
+// VEHICLE_ADD records continue with the SUMO id of the vehicle (uint16_t length followed by the characters)
+// and a Position. VEHICLE_MOVE records continue with a Position. VEHICLE_REMOVE records have nothing else.
+// The last record is a TRACE_END with the time the recording stopped (its vehicle is 0); a trace without it
+// is truncated.
+//
+// All the values are in host byte order.
+namespace MobilityTraceFormat {
+
+enum RecordType {
+    VEHICLE_ADD = 0,
+    VEHICLE_MOVE = 1,
+    VEHICLE_REMOVE = 2,
+    TRACE_END = 3,
+};
+
+const char MAGIC[4] = { 'F', 'L', 'D', 'M' };
+const uint32_t VERSION = 2;
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    int32_t timeScaleExp;
+};
+
+struct Position {
+    double x, y, z;
+    float speed; // m/s
+    float angle; // rad, as given to TraCIMobility
+};
+
+}
+
+#endif
@@ -0,0 +1,159 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "ReplayScenarioManager.h"
+
+#include <cstring>
+
+Define_Module(ReplayScenarioManager);
+
+void ReplayScenarioManager::initialize(int stage) {
+    LocalScenarioManager::initialize(stage);
+
+    if (stage != 1)
+        return;
+
+    fileName = par("traceFile").stdstringValue();
+
+    file = fopen(fileName.c_str(), "rb");
+    if (!file)
+        throw cRuntimeError("ReplayScenarioManager: cannot open mobility trace %s", fileName.c_str());
+
+    MobilityTraceFormat::FileHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, MobilityTraceFormat::MAGIC, sizeof(header.magic)) != 0)
+        throw cRuntimeError("ReplayScenarioManager: %s is not a mobility trace", fileName.c_str());
+
+    if (header.version != MobilityTraceFormat::VERSION)
+        throw cRuntimeError("ReplayScenarioManager: %s has version %u, expected %u", fileName.c_str(), header.version,
+                MobilityTraceFormat::VERSION);
+
+    // Raw times are only meaningful with the same time resolution
+    if (header.timeScaleExp != SimTime::getScaleExp())
+        throw cRuntimeError("ReplayScenarioManager: %s was recorded with simtime-scale %d, but the simulation uses %d",
+                fileName.c_str(), header.timeScaleExp, SimTime::getScaleExp());
+
+    stepTimer = new cMessage("replay step", REPLAY_STEP);
+
+    hasNext = readRecord(next);
+    scheduleNext();
+}
+
+void ReplayScenarioManager::finish() {
+    LocalScenarioManager::finish();
+
+    recordScalar("mobilityRecordsReplayed", recordsReplayed);
+
+    close();
+}
+
+void ReplayScenarioManager::handleMessage(cMessage* msg) {
+    if (msg != stepTimer) {
+        EV << "ReplayScenarioManager - Error: Got unexpected message! Name: " << msg->getName() << endl;
+        delete msg;
+        return;
+    }
+
+    // Past the end of the recording the vehicles would freeze and no new ones would enter
+    if (next.type == MobilityTraceFormat::TRACE_END && next.time < simTime())
+        throw cRuntimeError("ReplayScenarioManager: %s ends at %g s, record the mobility with a longer sim-time-limit",
+                fileName.c_str(), next.time.dbl());
+
+    while (hasNext && next.type != MobilityTraceFormat::TRACE_END && next.time <= simTime()) {
+        applyRecord(next);
+        hasNext = readRecord(next);
+    }
+
+    scheduleNext();
+}
+
+void ReplayScenarioManager::scheduleNext() {
+    if (!hasNext)
+        throw cRuntimeError("ReplayScenarioManager: %s is truncated", fileName.c_str());
+
+    if (next.type != MobilityTraceFormat::TRACE_END) {
+        scheduleAt(next.time, stepTimer);
+    } else {
+        // Fires only if the simulation goes on after the time the recording stopped
+        simtime_t afterEnd;
+        afterEnd.setRaw(next.time.raw() + 1);
+        scheduleAt(afterEnd, stepTimer);
+    }
+}
+
+bool ReplayScenarioManager::readRecord(Record& record) {
+    int64_t time;
+    uint32_t vehicle;
+
+    if (fread(&record.type, sizeof(record.type), 1, file) != 1)
+        return false;
+
+    if (fread(&time, sizeof(time), 1, file) != 1 || fread(&vehicle, sizeof(vehicle), 1, file) != 1)
+        throw cRuntimeError("ReplayScenarioManager: %s is truncated", fileName.c_str());
+
+    record.time.setRaw(time);
+    record.vehicle = vehicle;
+
+    if (record.type == MobilityTraceFormat::VEHICLE_ADD) {
+        uint16_t length;
+
+        if (fread(&length, sizeof(length), 1, file) != 1)
+            throw cRuntimeError("ReplayScenarioManager: %s is truncated", fileName.c_str());
+
+        record.externalId.resize(length);
+        if (length > 0 && fread(&record.externalId[0], 1, length, file) != length)
+            throw cRuntimeError("ReplayScenarioManager: %s is truncated", fileName.c_str());
+    }
+
+    if (record.type == MobilityTraceFormat::VEHICLE_ADD || record.type == MobilityTraceFormat::VEHICLE_MOVE) {
+        if (fread(&record.position, sizeof(record.position), 1, file) != 1)
+            throw cRuntimeError("ReplayScenarioManager: %s is truncated", fileName.c_str());
+    } else if (record.type != MobilityTraceFormat::VEHICLE_REMOVE && record.type != MobilityTraceFormat::TRACE_END) {
+        throw cRuntimeError("ReplayScenarioManager: unknown record type %d in %s", record.type, fileName.c_str());
+    }
+
+    return true;
+}
+
+void ReplayScenarioManager::applyRecord(const Record& record) {
+    Coord position(record.position.x, record.position.y, record.position.z);
+
+    switch (record.type) {
+        case MobilityTraceFormat::VEHICLE_ADD:
+            addVehicle(record.vehicle, record.externalId, position, record.position.speed, record.position.angle);
+            break;
+
+        case MobilityTraceFormat::VEHICLE_MOVE:
+            moveVehicle(record.vehicle, position, record.position.speed, record.position.angle);
+            break;
+
+        case MobilityTraceFormat::VEHICLE_REMOVE:
+            removeVehicle(record.vehicle);
+            break;
+    }
+
+    recordsReplayed++;
+}
+
+void ReplayScenarioManager::close() {
+    if (file) {
+        fclose(file);
+        file = NULL;
+    }
+}
+
+ReplayScenarioManager::~ReplayScenarioManager() {
+    cancelAndDelete(stepTimer);
+    close();
+}
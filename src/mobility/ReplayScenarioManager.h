@@ -0,0 +1,70 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __FLOODING_REPLAYSCENARIOMANAGER_H_
+#define __FLOODING_REPLAYSCENARIOMANAGER_H_
+
+#include <cstdio>
+#include <string>
+
+#include "LocalScenarioManager.h"
+#include "MobilityTraceFormat.h"
+
+// Plays back a trace written by MobilityRecorder. The records are streamed from the file: one self-message
+// fires at the time of the next record and applies every record with that time, in the order they were
+// recorded, so the hosts appear, move and disappear at the same instants as in the recorded run. Running past
+// the end of the trace is an error.
+class ReplayScenarioManager : public LocalScenarioManager
+{
+public:
+    virtual void initialize(int stage);
+    virtual void finish();
+    virtual void handleMessage(cMessage* msg);
+
+protected:
+    enum {
+        REPLAY_STEP = 1,
+    };
+
+    struct Record {
+        uint8_t type;
+        simtime_t time;
+        int vehicle;
+        std::string externalId;
+        MobilityTraceFormat::Position position;
+    };
+
+    FILE* file;
+    std::string fileName;
+
+    // Next record to apply, already read from the file
+    Record next;
+    bool hasNext;
+
+    cMessage* stepTimer;
+
+    long recordsReplayed;
+
+    virtual bool readRecord(Record& record);
+    virtual void applyRecord(const Record& record);
+    virtual void scheduleNext();
+    virtual void close();
+
+public:
+    ReplayScenarioManager() : file(NULL), hasNext(false), stepTimer(NULL), recordsReplayed(0) {}
+    virtual ~ReplayScenarioManager();
+};
+
+#endif
@@ -0,0 +1,93 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "HotPathProfiler.h"
+
+#include <cstdio>
+
+#include "FindModule.h"
+
+Define_Module(HotPathProfiler);
+
+HotPathProfiler* HotPathProfiler::get() {
+    HotPathProfiler* profiler = FindModule<HotPathProfiler*>::findGlobalModule();
+
+    // Parameters are available before initialize() runs
+    if (profiler && profiler->par("enabled").boolValue())
+        return profiler;
+
+    return NULL;
+}
+
+HotPathProfiler::Handler* HotPathProfiler::getHandler(const std::string& moduleType, const std::string& handler) {
+    return &handlers[moduleType][handler];
+}
+
+void HotPathProfiler::initialize() {
+    enabled = par("enabled").boolValue();
+}
+
+void HotPathProfiler::finish() {
+    if (!enabled)
+        return;
+
+    for (std::map<std::string, std::map<std::string, Handler> >::iterator i = handlers.begin(); i != handlers.end(); i++) {
+        for (std::map<std::string, Handler>::iterator j = i->second.begin(); j != i->second.end(); j++) {
+            std::string prefix = i->first + "." + j->first + ".";
+            const Handler& h = j->second;
+
+            recordScalar((prefix + "calls").c_str(), h.calls);
+            recordScalar((prefix + "totalTime").c_str(), h.totalNanoseconds / 1e9, "s");
+            recordScalar((prefix + "maxTime").c_str(), h.maxNanoseconds / 1e9, "s");
+
+            if (h.frames > 0) {
+                recordScalar((prefix + "frames").c_str(), h.frames);
+                recordScalar((prefix + "bytes").c_str(), h.bytes, "B");
+                recordScalar((prefix + "meanMacQueue").c_str(), (double) h.macQueueSum / h.frames);
+                recordScalar((prefix + "maxMacQueue").c_str(), h.macQueueMax);
+            }
+        }
+    }
+
+    std::string profileFile = par("profileFile").stdstringValue();
+    if (!profileFile.empty())
+        writeProfile(profileFile);
+}
+
+void HotPathProfiler::handleMessage(cMessage* msg) {
+    EV << "HotPathProfiler - Error: Got unexpected message! Name: " << msg->getName() << endl;
+    delete msg;
+}
+
+void HotPathProfiler::writeProfile(const std::string& fileName) {
+    FILE* file = fopen(fileName.c_str(), "w");
+    if (!file)
+        throw cRuntimeError("HotPathProfiler: cannot open profile file %s", fileName.c_str());
+
+    fprintf(file, "module\thandler\tcalls\ttotal_ns\tmean_ns\tmax_ns\tframes\tbytes\tmean_mac_queue\tmax_mac_queue\n");
+
+    for (std::map<std::string, std::map<std::string, Handler> >::iterator i = handlers.begin(); i != handlers.end(); i++) {
+        for (std::map<std::string, Handler>::iterator j = i->second.begin(); j != i->second.end(); j++) {
+            const Handler& h = j->second;
+
+            fprintf(file, "%s\t%s\t%ld\t%lld\t%.1f\t%lld\t%ld\t%ld\t%.2f\t%ld\n", i->first.c_str(), j->first.c_str(), h.calls,
+                    (long long) h.totalNanoseconds, h.calls > 0 ? (double) h.totalNanoseconds / h.calls : 0.0,
+                    (long long) h.maxNanoseconds, h.frames, h.bytes, h.frames > 0 ? (double) h.macQueueSum / h.frames : 0.0,
+                    h.macQueueMax);
+        }
+    }
+
+    fclose(file);
+}
@@ -0,0 +1,117 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __FLOODING_HOTPATHPROFILER_H_
+#define __FLOODING_HOTPATHPROFILER_H_
+
+#include <omnetpp.h>
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <time.h>
+
+#include "Mac1609_4.h"
+
+// Opt-in counters and wall-clock timers for the event handlers of the applications.
+//
+// The statistics are aggregated per module type and handler, not per host: every Flooding instance updates the
+// same Handler entries. Applications ask for their entries in initialize(); when profiling is disabled (or the
+// module is absent) they get NULL, and a Scope built on NULL does nothing, so the cost is one branch per
+// handler call. The totals are recorded as scalars of this module at finish() and, if profileFile is set,
+// also written to a tab-separated file with one line per handler.
+class HotPathProfiler : public cSimpleModule
+{
+public:
+    // Monotonic wall-clock time in nanoseconds
+    static int64_t now() {
+        timespec t;
+        clock_gettime(CLOCK_MONOTONIC, &t);
+        return (int64_t) t.tv_sec * 1000000000 + t.tv_nsec;
+    }
+
+    struct Handler {
+        long calls;
+        int64_t totalNanoseconds;
+        int64_t maxNanoseconds;
+
+        // Frames handed to the MAC, their size and the estimated length of the MAC queue when they were sent
+        long frames;
+        long bytes;
+        long macQueueSum;
+        long macQueueMax;
+
+        Handler() : calls(0), totalNanoseconds(0), maxNanoseconds(0), frames(0), bytes(0), macQueueSum(0), macQueueMax(0) {}
+
+        void addCall(int64_t nanoseconds) {
+            calls++;
+            totalNanoseconds += nanoseconds;
+            if (nanoseconds > maxNanoseconds)
+                maxNanoseconds = nanoseconds;
+        }
+
+        void addFrame(long length, long macQueue) {
+            frames++;
+            bytes += length;
+            macQueueSum += macQueue;
+            if (macQueue > macQueueMax)
+                macQueueMax = macQueue;
+        }
+    };
+
+    // Times the enclosing block and charges it to handler, if not NULL
+    class Scope {
+    public:
+        explicit Scope(Handler* handler) : handler(handler), start(0) {
+            if (handler)
+                start = now();
+        }
+
+        ~Scope() {
+            if (handler)
+                handler->addCall(now() - start);
+        }
+
+    private:
+        Handler* handler;
+        int64_t start;
+    };
+
+    // The profiler of the network if profiling is enabled, NULL otherwise
+    static HotPathProfiler* get();
+
+    // Entry for a handler of a module type. The pointer stays valid until the end of the simulation.
+    Handler* getHandler(const std::string& moduleType, const std::string& handler);
+
+    // Frames waiting in the MAC queues, estimated from the frames the application handed down so far and the
+    // frames the MAC transmitted or dropped. Mac1609_4 does not expose its queues.
+    static long estimateMacQueue(const Mac1609_4* mac, long framesHandedDown) {
+        long queued = framesHandedDown - mac->statsSentPackets - mac->statsDroppedPackets;
+        return queued > 0 ? queued : 0;
+    }
+
+    virtual void initialize();
+    virtual void finish();
+    virtual void handleMessage(cMessage* msg);
+
+protected:
+    bool enabled;
+
+    // By module type, then by handler
+    std::map<std::string, std::map<std::string, Handler> > handlers;
+
+    virtual void writeProfile(const std::string& fileName);
+};
+
+#endif
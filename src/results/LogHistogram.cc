@@ -0,0 +1,122 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "LogHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+LogHistogram::LogHistogram(double unit, double maxValue, int precisionBits) :
+        unit(unit), precisionBits(precisionBits) {
+    counts.resize(bucketIndex((uint64_t) std::ceil(maxValue / unit)) + 1);
+    clear();
+}
+
+void LogHistogram::add(double value) {
+    double units = std::max(value / unit, 0.0);
+
+    if (units >= bucketStart(counts.size()))
+        counts.back()++;
+    else
+        counts[bucketIndex((uint64_t) units)]++;
+
+    if (total == 0 || value < minValue)
+        minValue = value;
+    if (total == 0 || value > maxValue)
+        maxValue = value;
+
+    total++;
+    sum += value;
+}
+
+void LogHistogram::merge(const LogHistogram& other) {
+    if (other.total == 0)
+        return;
+
+    for (size_t i = 0; i < counts.size() && i < other.counts.size(); i++)
+        counts[i] += other.counts[i];
+
+    if (total == 0 || other.minValue < minValue)
+        minValue = other.minValue;
+    if (total == 0 || other.maxValue > maxValue)
+        maxValue = other.maxValue;
+
+    total += other.total;
+    sum += other.sum;
+}
+
+void LogHistogram::clear() {
+    std::fill(counts.begin(), counts.end(), 0);
+    total = 0;
+    sum = 0;
+    minValue = 0;
+    maxValue = 0;
+}
+
+double LogHistogram::percentile(double p) const {
+    if (total == 0)
+        return 0;
+
+    if (p >= 1)
+        return maxValue;
+
+    uint64_t rank = (uint64_t) std::ceil(std::min(std::max(p, 0.0), 1.0) * total);
+    uint64_t seen = 0;
+
+    for (size_t i = 0; i < counts.size(); i++) {
+        seen += counts[i];
+
+        if (seen >= rank && seen > 0) {
+            // Buckets one unit wide hold a single value, wider ones give their middle, but never a value
+            // outside the ones actually seen
+            double value = bucketStart(i + 1) - bucketStart(i) == 1 ? bucketLowerBound(i) : (bucketLowerBound(i) + bucketUpperBound(i)) / 2;
+            return std::min(std::max(value, minValue), maxValue);
+        }
+    }
+
+    return maxValue;
+}
+
+double LogHistogram::bucketLowerBound(size_t i) const {
+    return bucketStart(i) * unit;
+}
+
+double LogHistogram::bucketUpperBound(size_t i) const {
+    return bucketStart(i + 1) * unit;
+}
+
+size_t LogHistogram::bucketIndex(uint64_t units) const {
+    uint64_t subBuckets = (uint64_t) 1 << precisionBits;
+
+    if (units < subBuckets)
+        return units;
+
+    // Drop the bits below the precision: the index is shift * subBuckets plus the top precisionBits + 1 bits
+    int shift = 0;
+    while ((units >> shift) >= 2 * subBuckets)
+        shift++;
+
+    return shift * subBuckets + (units >> shift);
+}
+
+uint64_t LogHistogram::bucketStart(size_t i) const {
+    uint64_t subBuckets = (uint64_t) 1 << precisionBits;
+
+    if (i < 2 * subBuckets)
+        return i;
+
+    uint64_t shift = i / subBuckets - 1;
+    return (i - shift * subBuckets) << shift;
+}
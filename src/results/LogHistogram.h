@@ -0,0 +1,67 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __FLOODING_LOGHISTOGRAM_H_
+#define __FLOODING_LOGHISTOGRAM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Fixed-memory histogram with logarithmic buckets, in the spirit of HdrHistogram. Values are counted in
+// multiples of unit; below 2^precisionBits units every value has its own bucket, above it every power of two
+// is split in 2^precisionBits buckets, so the relative error of a percentile is below 2^-precisionBits. The
+// memory depends only on maxValue and precisionBits. Values above maxValue are counted in the last bucket.
+// Does not depend on OMNeT++ so that the offline tools can use it.
+class LogHistogram
+{
+public:
+    LogHistogram(double unit = 1, double maxValue = 1e6, int precisionBits = 7);
+
+    void add(double value);
+
+    // Adds the counts of other, which must have the same unit, maxValue and precisionBits
+    void merge(const LogHistogram& other);
+
+    void clear();
+
+    uint64_t count() const { return total; }
+    double min() const { return total ? minValue : 0; }
+    double max() const { return total ? maxValue : 0; }
+    double mean() const { return total ? sum / total : 0; }
+
+    // Value below which a fraction p (0..1) of the values are, to within the bucket resolution
+    double percentile(double p) const;
+
+    size_t numBuckets() const { return counts.size(); }
+    uint64_t bucketCount(size_t i) const { return counts[i]; }
+    double bucketLowerBound(size_t i) const;
+    double bucketUpperBound(size_t i) const;
+
+private:
+    double unit;
+    int precisionBits;
+    std::vector<uint64_t> counts;
+
+    uint64_t total;
+    double sum;
+    double minValue;
+    double maxValue;
+
+    size_t bucketIndex(uint64_t units) const;
+    uint64_t bucketStart(size_t i) const;
+};
+
+#endif
@@ -0,0 +1,105 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "LogHistogramStatistic.h"
+
+void LogHistogramStatistic::setup(double unit, double maxValue, int precisionBits) {
+    histogram = LogHistogram(unit, maxValue, precisionBits);
+    cStdDev::clearResult();
+}
+
+void LogHistogramStatistic::collect(double value) {
+    // The moments are kept by cStdDev; the precollection of cDensityEstBase is not needed
+    cStdDev::collect(value);
+    histogram.add(value);
+}
+
+void LogHistogramStatistic::clearResult() {
+    cStdDev::clearResult();
+    histogram.clear();
+}
+
+int LogHistogramStatistic::getNumCells() const {
+    if (histogram.count() == 0)
+        return 0;
+
+    size_t last = histogram.numBuckets() - 1;
+    while (histogram.bucketCount(last) == 0)
+        last--;
+
+    return last - firstBucket() + 1;
+}
+
+double LogHistogramStatistic::getBasepoint(int k) const {
+    return histogram.bucketLowerBound(firstBucket() + k);
+}
+
+double LogHistogramStatistic::getCellValue(int k) const {
+    return histogram.bucketCount(firstBucket() + k);
+}
+
+double LogHistogramStatistic::getPDF(double x) const {
+    if (histogram.count() == 0)
+        return 0;
+
+    for (size_t i = 0; i < histogram.numBuckets(); i++) {
+        double lower = histogram.bucketLowerBound(i);
+        double upper = histogram.bucketUpperBound(i);
+
+        if (x >= lower && x < upper)
+            return histogram.bucketCount(i) / (histogram.count() * (upper - lower));
+    }
+
+    return 0;
+}
+
+double LogHistogramStatistic::getCDF(double x) const {
+    if (histogram.count() == 0)
+        return 0;
+
+    double below = 0;
+
+    for (size_t i = 0; i < histogram.numBuckets(); i++) {
+        double lower = histogram.bucketLowerBound(i);
+        double upper = histogram.bucketUpperBound(i);
+
+        if (x >= upper) {
+            below += histogram.bucketCount(i);
+        } else {
+            // Values assumed evenly spread within the bucket
+            if (x > lower)
+                below += histogram.bucketCount(i) * (x - lower) / (upper - lower);
+            break;
+        }
+    }
+
+    return below / histogram.count();
+}
+
+void LogHistogramStatistic::doMergeCellValues(const cDensityEstBase* other) {
+    const LogHistogramStatistic* log = dynamic_cast<const LogHistogramStatistic*>(other);
+    if (!log)
+        throw cRuntimeError("LogHistogramStatistic: cannot merge a %s", other->getClassName());
+
+    histogram.merge(log->histogram);
+}
+
+size_t LogHistogramStatistic::firstBucket() const {
+    size_t first = 0;
+    while (first + 1 < histogram.numBuckets() && histogram.bucketCount(first) == 0)
+        first++;
+
+    return first;
+}
@@ -0,0 +1,59 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __FLOODING_LOGHISTOGRAMSTATISTIC_H_
+#define __FLOODING_LOGHISTOGRAMSTATISTIC_H_
+
+#include <omnetpp.h>
+
+#include "LogHistogram.h"
+
+// Density estimate backed by a LogHistogram, so that it can be written to the .sca file with recordStatistic()
+// like any OMNeT++ histogram. Unlike cDoubleHistogram it needs no range precollection: the buckets are fixed by
+// setup() and the memory does not grow with the number of values. Only the buckets between the first and the
+// last non-empty one are exported as cells.
+class LogHistogramStatistic : public cDensityEstBase
+{
+public:
+    LogHistogramStatistic(const char* name = NULL) : cDensityEstBase(name) {}
+
+    // See LogHistogram. Clears the values collected so far.
+    void setup(double unit, double maxValue, int precisionBits);
+
+    const LogHistogram& getHistogram() const { return histogram; }
+
+    virtual void collect(double value);
+    virtual void clearResult();
+
+    virtual bool isTransformed() const { return true; }
+    virtual void transform() {}
+
+    virtual int getNumCells() const;
+    virtual double getBasepoint(int k) const;
+    virtual double getCellValue(int k) const;
+    virtual double getPDF(double x) const;
+    virtual double getCDF(double x) const;
+
+protected:
+    LogHistogram histogram;
+
+    virtual void collectTransformed(double value) {}
+    virtual void doMergeCellValues(const cDensityEstBase* other);
+
+    // Index of the bucket of the first exported cell
+    size_t firstBucket() const;
+};
+
+#endif
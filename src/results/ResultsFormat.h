@@ -0,0 +1,57 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __FLOODING_RESULTSFORMAT_H_
+#define __FLOODING_RESULTSFORMAT_H_
+
+#include <stdint.h>
+
+// Layout of the results file written by ResultsSink. This header does not depend on OMNeT++ so that the
+// offline tools can include it.
+//
+// The file starts with a FileHeader followed by any number of blocks. A block is a uint32_t row count n
+// followed by the columns of its n records, each stored contiguously in this order:
+//
+//     int64_t  time[n]       reception (or transmission) time, raw simulation time in 10^timeScaleExp s
+//     int32_t  messageID[n]
+//     int32_t  length[n]     message length, as written to the text logs
+//     double   distance[n]   distance to the message origin at reception (0 for sender records)
+//     int32_t  hops[n]       number of hops at reception (0 for sender records)
+//     int32_t  nodeId[n]     myId of the host that wrote the record
+//     int32_t  eventID[n]    dissemination event of the message
+//     uint8_t  type[n]       RecordType
+//
+// All the values are in host byte order.
+namespace ResultsFormat {
+
+enum RecordType {
+    SENDER = 0,
+    RECEIVER = 1,
+};
+
+const char MAGIC[4] = { 'F', 'L', 'D', 'R' };
+const uint32_t VERSION = 2;
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    int32_t traffic; // log_traffic of the run
+    int32_t replication; // log_replication of the run
+    int32_t timeScaleExp;
+};
+
+}
+
+#endif
@@ -0,0 +1,145 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "ResultsSink.h"
+
+#include <cstring>
+#include <sstream>
+
+Define_Module(ResultsSink);
+
+void ResultsSink::initialize() {
+    int precisionBits = par("histogramPrecisionBits").longValue();
+    delayHistogram.setup(par("delayResolution").doubleValue(), par("maxDelay").doubleValue(), precisionBits);
+    hopsHistogram.setup(1, par("maxHops").longValue(), precisionBits);
+    distanceHistogram.setup(par("distanceResolution").doubleValue(), par("maxDistance").doubleValue(), precisionBits);
+
+    std::string fileName = par("fileName").stdstringValue();
+
+    if (fileName.empty()) {
+        std::ostringstream o;
+        o << "./results/" << par("log_traffic").longValue() << "-" << par("log_replication").longValue() << ".rec";
+        fileName = o.str();
+    }
+
+    file = fopen(fileName.c_str(), "wb");
+    if (!file)
+        throw cRuntimeError("ResultsSink: cannot open results file %s", fileName.c_str());
+
+    ResultsFormat::FileHeader header;
+    memcpy(header.magic, ResultsFormat::MAGIC, sizeof(header.magic));
+    header.version = ResultsFormat::VERSION;
+    header.traffic = par("log_traffic").longValue();
+    header.replication = par("log_replication").longValue();
+    header.timeScaleExp = SimTime::getScaleExp();
+    fwrite(&header, sizeof(header), 1, file);
+
+    blockSize = par("blockSize").longValue();
+    times.reserve(blockSize);
+    messageIDs.reserve(blockSize);
+    lengths.reserve(blockSize);
+    distances.reserve(blockSize);
+    hops.reserve(blockSize);
+    nodeIds.reserve(blockSize);
+    eventIDs.reserve(blockSize);
+    types.reserve(blockSize);
+}
+
+void ResultsSink::finish() {
+    close();
+
+    recordHistogram(delayHistogram, "s");
+    recordHistogram(hopsHistogram, NULL);
+    recordHistogram(distanceHistogram, "m");
+}
+
+void ResultsSink::recordHistogram(LogHistogramStatistic& statistic, const char* unit) {
+    static const double percentiles[] = { 0.5, 0.9, 0.99, 0.999 };
+    static const char* names[] = { "p50", "p90", "p99", "p999" };
+
+    recordStatistic(&statistic, unit);
+
+    for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++) {
+        std::string name = std::string(statistic.getName()) + ":" + names[i];
+        recordScalar(name.c_str(), statistic.getHistogram().percentile(percentiles[i]), unit);
+    }
+}
+
+void ResultsSink::handleMessage(cMessage* msg) {
+    EV << "ResultsSink - Error: Got unexpected message! Name: " << msg->getName() << endl;
+    delete msg;
+}
+
+void ResultsSink::append(ResultsFormat::RecordType type, int nodeId, int eventID, simtime_t time, int messageID, int length,
+        double distanceToOrigin, int hopCount) {
+    if (!file)
+        return;
+
+    times.push_back(time.raw());
+    messageIDs.push_back(messageID);
+    lengths.push_back(length);
+    distances.push_back(distanceToOrigin);
+    hops.push_back(hopCount);
+    nodeIds.push_back(nodeId);
+    eventIDs.push_back(eventID);
+    types.push_back(type);
+
+    if (times.size() >= blockSize)
+        flush();
+}
+
+void ResultsSink::recordReception(simtime_t delay, int hopCount, double distanceToOrigin) {
+    delayHistogram.collect(delay.dbl());
+    hopsHistogram.collect(hopCount);
+    distanceHistogram.collect(distanceToOrigin);
+}
+
+void ResultsSink::flush() {
+    uint32_t rows = times.size();
+
+    if (!file || rows == 0)
+        return;
+
+    fwrite(&rows, sizeof(rows), 1, file);
+    fwrite(&times[0], sizeof(int64_t), rows, file);
+    fwrite(&messageIDs[0], sizeof(int32_t), rows, file);
+    fwrite(&lengths[0], sizeof(int32_t), rows, file);
+    fwrite(&distances[0], sizeof(double), rows, file);
+    fwrite(&hops[0], sizeof(int32_t), rows, file);
+    fwrite(&nodeIds[0], sizeof(int32_t), rows, file);
+    fwrite(&eventIDs[0], sizeof(int32_t), rows, file);
+    fwrite(&types[0], sizeof(uint8_t), rows, file);
+
+    times.clear();
+    messageIDs.clear();
+    lengths.clear();
+    distances.clear();
+    hops.clear();
+    nodeIds.clear();
+    eventIDs.clear();
+    types.clear();
+}
+
+void ResultsSink::close() {
+    if (file) {
+        flush();
+        fclose(file);
+        file = NULL;
+    }
+}
+
+ResultsSink::~ResultsSink() {
+    close();
+}
@@ -0,0 +1,75 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __FLOODING_RESULTSSINK_H_
+#define __FLOODING_RESULTSSINK_H_
+
+#include <omnetpp.h>
+#include <cstdio>
+#include <vector>
+
+#include "LogHistogramStatistic.h"
+#include "ResultsFormat.h"
+
+// Shared sink for the sender and receiver logs. Instead of one text file per host, every host appends
+// fixed-size records that are buffered here and written to a single binary file per run, one column
+// block at a time. The file layout is described in ResultsFormat.h.
+//
+// The end-to-end delay, hop count and distance to the origin of every reception are also collected in
+// log-bucketed histograms shared by all the hosts, which are recorded in the .sca file with their
+// percentiles, so the tail figures do not need the results file.
+class ResultsSink : public cSimpleModule
+{
+public:
+    ResultsSink() :
+            file(NULL), delayHistogram("endToEndDelay"), hopsHistogram("hopCount"), distanceHistogram("distanceToOrigin") {}
+
+    void append(ResultsFormat::RecordType type, int nodeId, int eventID, simtime_t time, int messageID, int length,
+            double distanceToOrigin, int hops);
+
+    // Adds the first reception of a message by a host to the histograms
+    void recordReception(simtime_t delay, int hops, double distanceToOrigin);
+
+    virtual ~ResultsSink();
+
+protected:
+    FILE* file;
+
+    size_t blockSize;
+
+    // Column buffers of the block being filled
+    std::vector<int64_t> times;
+    std::vector<int32_t> messageIDs;
+    std::vector<int32_t> lengths;
+    std::vector<double> distances;
+    std::vector<int32_t> hops;
+    std::vector<int32_t> nodeIds;
+    std::vector<int32_t> eventIDs;
+    std::vector<uint8_t> types;
+
+    LogHistogramStatistic delayHistogram;
+    LogHistogramStatistic hopsHistogram;
+    LogHistogramStatistic distanceHistogram;
+
+    virtual void initialize();
+    virtual void finish();
+    virtual void handleMessage(cMessage* msg);
+
+    virtual void flush();
+    virtual void recordHistogram(LogHistogramStatistic& statistic, const char* unit);
+    virtual void close();
+};
+
+#endif
@@ -0,0 +1,32 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "BackTrafficGenerator.h"
+
+bool BackTrafficGenerator::admit(int address, simtime_t expiry) {
+    if (!requesters.insert(address).second)
+        return false;
+
+    expiries.push_back(std::make_pair(expiry, address));
+
+    return true;
+}
+
+void BackTrafficGenerator::expire(simtime_t now) {
+    while (!expiries.empty() && expiries.front().first <= now) {
+        requesters.erase(expiries.front().second);
+        expiries.pop_front();
+    }
+}
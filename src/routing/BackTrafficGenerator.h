@@ -0,0 +1,53 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __FLOODING_BACKTRAFFICGENERATOR_H_
+#define __FLOODING_BACKTRAFFICGENERATOR_H_
+
+#include <omnetpp.h>
+#include <deque>
+#include <set>
+
+// State of the back-traffic application: the beacon senders that requested a burst within the last hold time
+// and the number of packets still to be sent. Every requester is held for the same amount of time, so the
+// expiry times are ordered by arrival and a single timer pointing at the head of the queue serves them all.
+class BackTrafficGenerator
+{
+public:
+    BackTrafficGenerator() : pendingPackets(0) {}
+
+    // Registers a burst request from a beacon sender. Returns false if the sender is still being held.
+    bool admit(int address, simtime_t expiry);
+
+    // Forgets the requesters whose hold time is over
+    void expire(simtime_t now);
+
+    bool hasRequesters() const { return !expiries.empty(); }
+
+    // Expiry time of the oldest requester. Only valid if hasRequesters()
+    simtime_t nextExpiry() const { return expiries.front().first; }
+
+    void addPackets(long count) { pendingPackets += count; }
+    void removePacket() { pendingPackets--; }
+    long getPendingPackets() const { return pendingPackets; }
+
+private:
+    std::set<int> requesters;
+    std::deque<std::pair<simtime_t, int> > expiries;
+
+    long pendingPackets;
+};
+
+#endif
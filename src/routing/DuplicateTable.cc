@@ -0,0 +1,102 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "DuplicateTable.h"
+
+#include <limits>
+
+const int64_t DuplicateTable::EMPTY_SLOT = std::numeric_limits<int64_t>::min();
+
+DuplicateTable::DuplicateTable(size_t initialCapacity) {
+    size_t capacity = 8;
+    while (capacity < initialCapacity)
+        capacity <<= 1;
+
+    Slot empty;
+    empty.key = EMPTY_SLOT;
+
+    slots.assign(capacity, empty);
+    mask = capacity - 1;
+    used = 0;
+    earliestExpiry = MAXTIME;
+}
+
+size_t DuplicateTable::findSlot(int64_t key) const {
+    // Fibonacci hashing spreads the consecutive IDs generated by the RSU over the whole table. The high half of
+    // the product depends on both the event and the message ID.
+    size_t i = (size_t) (((uint64_t) key * 11400714819323198485ull) >> 32) & mask;
+
+    while (slots[i].key != EMPTY_SLOT && slots[i].key != key)
+        i = (i + 1) & mask;
+
+    return i;
+}
+
+bool DuplicateTable::contains(int64_t key) const {
+    return slots[findSlot(key)].key == key;
+}
+
+bool DuplicateTable::insert(int64_t key, simtime_t expiry) {
+    size_t i = findSlot(key);
+
+    if (slots[i].key == key)
+        return false;
+
+    slots[i].key = key;
+    slots[i].expiry = expiry;
+    used++;
+
+    if (expiry < earliestExpiry)
+        earliestExpiry = expiry;
+
+    // Keep the load factor under 3/4 so that probe sequences stay short
+    if (used * 4 > slots.size() * 3)
+        rebuild(slots.size() * 2, -1);
+
+    return true;
+}
+
+void DuplicateTable::purgeExpired(simtime_t now) {
+    if (used == 0 || now < earliestExpiry)
+        return;
+
+    rebuild(slots.size(), now);
+}
+
+void DuplicateTable::rebuild(size_t capacity, simtime_t now) {
+    std::vector<Slot> old;
+    old.swap(slots);
+
+    Slot empty;
+    empty.key = EMPTY_SLOT;
+
+    slots.assign(capacity, empty);
+    mask = capacity - 1;
+    used = 0;
+    earliestExpiry = MAXTIME;
+
+    for (std::vector<Slot>::iterator i = old.begin(); i != old.end(); i++) {
+        // A negative time means the table is only growing and nothing is dropped
+        if (i->key == EMPTY_SLOT || (now >= SIMTIME_ZERO && i->expiry <= now))
+            continue;
+
+        size_t j = findSlot(i->key);
+        slots[j] = *i;
+        used++;
+
+        if (i->expiry < earliestExpiry)
+            earliestExpiry = i->expiry;
+    }
+}
@@ -0,0 +1,61 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __FLOODING_DUPLICATETABLE_H_
+#define __FLOODING_DUPLICATETABLE_H_
+
+#include <omnetpp.h>
+#include <stdint.h>
+#include <vector>
+
+// Set of the messages already accepted by a host. Messages are identified by a 64-bit key, so that the IDs of
+// several dissemination events can be combined with their event ID (see Flooding::messageKey). Entries are stored inline in an open-addressed table
+// (linear probing, power-of-two capacity) and are dropped once the message they refer to has expired, i.e.
+// after messageOriginTime + messageTTL. An expired message is rejected by the TTL check before the duplicate
+// check, so forgetting it does not change which messages are treated as duplicates.
+class DuplicateTable
+{
+public:
+    DuplicateTable(size_t initialCapacity = 64);
+
+    bool contains(int64_t key) const;
+
+    // Returns false if the message was already in the table
+    bool insert(int64_t key, simtime_t expiry);
+
+    // Drops all the entries whose expiry time is not after now. It only sweeps the table when at least one
+    // entry has actually expired, so it is cheap to call on every reception.
+    void purgeExpired(simtime_t now);
+
+    size_t size() const { return used; }
+
+private:
+    struct Slot {
+        int64_t key;
+        simtime_t expiry;
+    };
+
+    static const int64_t EMPTY_SLOT;
+
+    std::vector<Slot> slots;
+    size_t used;
+    size_t mask;
+    simtime_t earliestExpiry;
+
+    size_t findSlot(int64_t key) const;
+    void rebuild(size_t capacity, simtime_t now);
+};
+
+#endif
@@ -15,8 +15,38 @@
 
 #include "Flooding.h"
 
+#include <cstring>
+
 Define_Module(Flooding);
 
+// Whether the sender of packet (DataMessage or DataBundle) designated address as a relay. An empty list
+// designates every receiver.
+template<typename Packet>
+static bool listsRelay(const Packet* packet, int address) {
+    unsigned int count = packet->getRelaysArraySize();
+
+    if (count == 0)
+        return true;
+
+    for (unsigned int i = 0; i < count; i++) {
+        if (packet->getRelays(i) == address)
+            return true;
+    }
+
+    return false;
+}
+
+// Writes the relay list into packet. Every address takes 4 bytes of the packet.
+template<typename Packet>
+static void setRelays(Packet* packet, const std::vector<int>& relays) {
+    packet->setRelaysArraySize(relays.size());
+
+    for (unsigned int i = 0; i < relays.size(); i++)
+        packet->setRelays(i, relays[i]);
+
+    packet->setByteLength(4 * relays.size());
+}
+
 const simsignalwrap_t Flooding::mobilityStateChangedSignal = simsignalwrap_t(MIXIM_SIGNAL_MOBILITY_CHANGE_NAME);
 
 void Flooding::initialize(int stage)
@@ -24,8 +54,6 @@ void Flooding::initialize(int stage)
     BaseWaveApplLayer::initialize(stage);
 
     if (stage == 0) {
-        traci = Veins::TraCIMobilityAccess().get(getParentModule());
-
         //TODO: Added for Game Theory Solution
         lastTxPower = registerSignal("lastTxPower");
         meanSNR = registerSignal("meanSNR");
@@ -34,17 +62,101 @@ void Flooding::initialize(int stage)
         collisions = registerSignal("collisions");
         duplicatedMessages = registerSignal("duplicatedMessages");
         messagesTransmitted = registerSignal("messagesTransmitted");
+        bundlesTransmitted = registerSignal("bundlesTransmitted");
+        rebroadcastsSuppressed = registerSignal("rebroadcastsSuppressed");
+        notDesignatedRelay = registerSignal("notDesignatedRelay");
         messagesReceived = registerSignal("messagesReceived");
         isInROI = registerSignal("isInROI");
-
-        wasInROI = false;
-        disseminationStarted = false;
-
-        getSimulation()->getSystemModule()->subscribe("disseminationStartTime", this);
+        messageObjectsPerFrame = registerSignal("messageObjectsPerFrame");
+        messagesTransmittedSCF = registerSignal("messagesTransmittedSCF");
+        messagesReceivedSCF = registerSignal("messagesReceivedSCF");
+        forwardHoldTime = registerSignal("forwardHoldTime");
+
+        cfg.eventOrigin = Coord(par("eventOriginX").doubleValue(), par("eventOriginY").doubleValue(), par("eventOriginZ").doubleValue());
+        cfg.dataROI = par("dataROI").doubleValue();
+        cfg.beaconRange = cfg.dataROI + 300;
+        cfg.startDataProductionTime = par("startDataProductionTime").doubleValue();
+        cfg.beaconStartTime = cfg.startDataProductionTime - 3;
+        cfg.beaconInterval = par("beaconInterval").doubleValue();
+        cfg.adaptTxPower = par("adaptTxPower").boolValue();
+        cfg.generateBackTraffic = par("generateBackTraffic").boolValue();
+        cfg.backTrafficBurstSize = par("backTrafficBurstSize").longValue();
+        if (cfg.backTrafficBurstSize < 1)
+            throw cRuntimeError("Flooding: backTrafficBurstSize must be at least 1, got %d", cfg.backTrafficBurstSize);
+        cfg.backTrafficPacketSize = par("backTrafficPacketSize").longValue();
+        cfg.backTrafficHoldTime = par("backTrafficHoldTime").doubleValue();
+        double backTrafficRate = par("backTrafficRate").doubleValue();
+        cfg.backTrafficInterval = backTrafficRate > 0 ? cfg.backTrafficPacketSize * 8 / backTrafficRate : 0;
+
+        std::string suppression = par("suppression").stdstringValue();
+        if (suppression == "none")
+            cfg.suppressionMode = SUPPRESSION_NONE;
+        else if (suppression == "counter")
+            cfg.suppressionMode = SUPPRESSION_COUNTER;
+        else if (suppression == "distance")
+            cfg.suppressionMode = SUPPRESSION_DISTANCE;
+        else if (suppression == "gossip")
+            cfg.suppressionMode = SUPPRESSION_GOSSIP;
+        else
+            throw cRuntimeError("Flooding: unknown suppression scheme '%s'", suppression.c_str());
+
+        cfg.suppressionCounterThreshold = par("suppressionCounterThreshold").longValue();
+        cfg.suppressionDistance = par("suppressionDistance").doubleValue();
+        cfg.suppressionRange = par("suppressionRange").doubleValue();
+        cfg.suppressionMaxDelay = par("suppressionMaxDelay").doubleValue();
+        cfg.gossipProbability = par("gossipProbability").doubleValue();
+
+        std::string relaySelection = par("relaySelection").stdstringValue();
+        if (relaySelection == "none")
+            cfg.relaySelection = RELAY_ALL;
+        else if (relaySelection == "farthest")
+            cfg.relaySelection = RELAY_FARTHEST;
+        else if (relaySelection == "sectors")
+            cfg.relaySelection = RELAY_SECTORS;
+        else
+            throw cRuntimeError("Flooding: unknown relay selection scheme '%s'", relaySelection.c_str());
+
+        cfg.relayCount = par("relayCount").longValue();
+
+        cfg.scfBufferSize = par("scfBufferSize").longValue();
+        cfg.scfRetryInterval = par("scfRetryInterval").doubleValue();
+
+        std::string scfEviction = par("scfEviction").stdstringValue();
+        if (scfEviction == "oldest")
+            cfg.scfEviction = SCF_EVICT_OLDEST;
+        else if (scfEviction == "expiring")
+            cfg.scfEviction = SCF_EVICT_EXPIRING;
+        else if (scfEviction == "hops")
+            cfg.scfEviction = SCF_EVICT_HOPS;
+        else
+            throw cRuntimeError("Flooding: unknown store-carry-forward eviction policy '%s'", scfEviction.c_str());
+        neighbors.setHoldTime(par("neighborHoldTime").doubleValue());
+        cfg.aggregationWindow = par("aggregationWindow").doubleValue();
+        cfg.aggregationMaxBytes = par("aggregationMaxBytes").longValue();
+
+        backTrafficEntryTimer = new cMessage("back traffic entry timeout", BACK_TRAFFIC_ENTRY_TIMEOUT);
+        backTrafficSendTimer = new cMessage("send back traffic", BACK_TRAFFIC_SEND);
+        backTrafficPrototype = NULL;
+        backTrafficSerial = 0;
+
+        bundleBytes = 0;
+        aggregationTimer = new cMessage("send bundle", AGGREGATION_FLUSH);
+
+        cfg.schAlignedForwarding = par("schAlignedForwarding").boolValue();
+        cfg.schSpreadWindow = par("schSpreadWindow").doubleValue();
+        // Frames released after the SCH interval would wait for the next one in the MAC
+        if (cfg.schSpreadWindow > SWITCHING_INTERVAL_11P - GUARD_INTERVAL_11P)
+            throw cRuntimeError("Flooding: schSpreadWindow must not exceed the SCH interval minus the guard interval");
+        schReleaseTimer = new cMessage("release held frames", SCH_RELEASE);
+
+        broker = FindModule<DisseminationBroker*>::findGlobalModule();
+        brokerHandle = -1;
 
         mac = FindModule<Mac1609_4*>::findSubModule(getParentModule());
         assert(mac);
 
+        resultsSink = FindModule<ResultsSink*>::findGlobalModule();
+
         //TODO: Added for Game Theory Solution
         curTxPower = mac->par("txPower");
         powerLevel = 3;
@@ -53,30 +165,31 @@ void Flooding::initialize(int stage)
         lastNumCollisions = 0;
         totalCollisions = 0;
 
-        CCHStartTimer = new cMessage("CCH start", CCH_START);
-        SCHStartTimer = new cMessage("SCH start", SCH_START);
-
-        uint64_t currenTime = simTime().raw();
-        uint64_t switchingTime = SWITCHING_INTERVAL_11P.raw();
-        double timeToNextSwitch = (double)(switchingTime - (currenTime % switchingTime)) / simTime().getScale();
-
-        // Control Channel is active
-        if ((currenTime / switchingTime) % 2 == 0) {
-            scheduleAt(simTime() + timeToNextSwitch + SWITCHING_INTERVAL_11P, CCHStartTimer);
-            scheduleAt(simTime() + timeToNextSwitch, SCHStartTimer);
-        }
-        // Service Channel is active
-        else {
-            scheduleAt(simTime() + timeToNextSwitch, CCHStartTimer);
-            scheduleAt(simTime() + timeToNextSwitch + SWITCHING_INTERVAL_11P, SCHStartTimer);
+        // BaseWaveApplLayer schedules the beacons from the start; they are armed from the mobility updates instead
+        beaconingEnabled = sendBeaconEvt->isScheduled();
+        if (beaconingEnabled) {
+            beaconPhase = sendBeaconEvt->getArrivalTime();
+            cancelEvent(sendBeaconEvt);
         }
+
+        framesHandedDown = 0;
+        frameObjects = 0;
+        initProfile();
+
+        // The collisions are sampled at the interval boundaries notified by the network-wide clock, so the hosts
+        // do not schedule timers of their own
+        channelClock = FindModule<ChannelIntervalClock*>::findGlobalModule();
+        if (channelClock)
+            channelClock->subscribe(ChannelIntervalClock::intervalStartSignal, this);
+        else if (cfg.schAlignedForwarding)
+            throw cRuntimeError("Flooding: SCH-aligned forwarding needs a ChannelIntervalClock in the network");
     }
 }
 
 void Flooding::finish() {
     BaseWaveApplLayer::finish();
 
-    if (wasInROI) {
+    if (broker && broker->wasInROI(myId)) {
         emit(isInROI, 1);
     } else {
         emit(isInROI, 0);
@@ -87,61 +200,62 @@ void Flooding::finish() {
 
     emit(collisions, totalCollisions);
 
-    if (!messagesRcvd.empty()) {
-        std::ofstream log;
-        std::ostringstream o;
-
-        o << "./results/" << par("log_traffic").longValue() << "-" << par("log_replication").longValue() << "-receiver-" << myId;
-        log.open(o.str().c_str());
-
-        for (std::map<int, MessageInfoEntry*>::iterator i = messagesRcvd.begin(); i != messagesRcvd.end(); i++) {
-            MessageInfoEntry* videoInfo = i->second;
+    if (channelClock) {
+        channelClock->unsubscribe(ChannelIntervalClock::intervalStartSignal, this);
+        channelClock = NULL;
+    }
 
-            log << videoInfo->receptionTime << " " << "id " << videoInfo->messageID << " " << "udp " << videoInfo->messageLength << " " << videoInfo->distanceToOrigin << endl;
-        }
-        log.close();
+    if (brokerHandle >= 0) {
+        broker->removeVehicle(brokerHandle);
+        brokerHandle = -1;
     }
-    getSimulation()->getSystemModule()->unsubscribe("disseminationStartTime", this);
 }
 
 void Flooding::handleSelfMsg(cMessage* msg) {
-    switch (msg->getKind()) {
+    int kind = msg->getKind();
+    HotPathProfiler::Scope scope(kind >= SEND_BEACON_EVT && kind <= SCH_RELEASE ? profile.selfMsg[kind - SEND_BEACON_EVT] : NULL);
+
+    switch (kind) {
         case SEND_BEACON_EVT: {
-            WaveShortMessage* wsm = prepareWSM("beacon", beaconLengthBits, type_CCH, beaconPriority, 0, -1);
+            // Only scheduled while the vehicle is inside the beacon range and after beaconStartTime
+            sendWSM(prepareWSM("beacon", beaconLengthBits, type_CCH, beaconPriority, 0, -1));
 
-            Coord rsuPosition = Coord(par("eventOriginX").doubleValue(), par("eventOriginY").doubleValue(), par("eventOriginZ").doubleValue());
-            if (simTime() > par("startDataProductionTime").doubleValue() - 3 &&
-                    curPosition.distance(rsuPosition) <= par("dataROI").doubleValue() + 300) {
+            scheduleAt(simTime() + cfg.beaconInterval, sendBeaconEvt);
 
-                sendWSM(wsm);
-            } else {
-                delete wsm;
-            }
+            break;
+        }
 
-            scheduleAt(simTime() + par("beaconInterval").doubleValue(), sendBeaconEvt);
+        case BACK_TRAFFIC_ENTRY_TIMEOUT: {
+            backTraffic.expire(simTime());
+
+            if (backTraffic.hasRequesters())
+                scheduleAt(backTraffic.nextExpiry(), backTrafficEntryTimer);
 
             break;
         }
 
-        case BACK_TRAFFIC_ENTRY_TIMEOUT: {
-            NeighborEntry* entry = (NeighborEntry*) msg->getContextPointer();
-            int address = entry->senderAddress;
-            cancelAndDelete(entry->beaconHoldTimer);
-            entry->beaconHoldTimer = NULL;
-            lastRequesters.erase(address);
+        case BACK_TRAFFIC_SEND: {
+            if (backTraffic.getPendingPackets() > 0)
+                sendBackTrafficPacket();
+
+            if (backTraffic.getPendingPackets() > 0)
+                scheduleAt(simTime() + cfg.backTrafficInterval, backTrafficSendTimer);
 
             break;
         }
 
-        case CCH_START: {
-            totalCollisions = totalCollisions + mac->statsTXRXLostPackets - lastNumCollisions;
-            scheduleAt(simTime() + SWITCHING_INTERVAL_11P + SWITCHING_INTERVAL_11P, CCHStartTimer);
+        case REBROADCAST_EVT: {
+            onForwardTimeout((PendingForward*) msg->getContextPointer());
             break;
         }
 
-        case SCH_START: {
-            lastNumCollisions = mac->statsTXRXLostPackets;
-            scheduleAt(simTime() + SWITCHING_INTERVAL_11P + SWITCHING_INTERVAL_11P, SCHStartTimer);
+        case AGGREGATION_FLUSH: {
+            sendBundle();
+            break;
+        }
+
+        case SCH_RELEASE: {
+            releaseHeldFrames();
             break;
         }
 
@@ -154,41 +268,304 @@ void Flooding::handleSelfMsg(cMessage* msg) {
 }
 
 void Flooding::onBeacon(WaveShortMessage* wsm) {
-    Coord rsuPosition = Coord(par("eventOriginX").doubleValue(), par("eventOriginY").doubleValue(), par("eventOriginZ").doubleValue());
+    HotPathProfiler::Scope scope(profile.onBeacon);
+
+    neighbors.purgeExpired(simTime());
+    bool newNeighbor = neighbors.update(wsm->getSenderAddress(), wsm->getSenderPos(), simTime());
+
+    // A new neighbor may not have the messages this vehicle carries
+    if (newNeighbor && !carriedMessages.empty())
+        forwardCarried();
+
     // if back-traffic is enabled, then generate it only three seconds before the main dissemination.
-    if (par("generateBackTraffic").boolValue() && simTime() > par("startDataProductionTime").doubleValue() - 3
-            && curPosition.distance(rsuPosition) <= par("dataROI").doubleValue() + 300) {
+    if (cfg.generateBackTraffic && simTime() > beaconStartTime()) {
         processBackTraffic(wsm->getSenderAddress());
     }
 }
 
 void Flooding::onData(WaveShortMessage* wsm) {
+    HotPathProfiler::Scope scope(profile.onData);
+
+    frameObjects = 0;
+
     //TODO: Added for GAme Theory Solution
-    if (par("adaptTxPower").boolValue())
+    if (cfg.adaptTxPower)
         adjustTxPower(wsm);
 
-    MessageInfoEntry* info = extractMsgInfo(wsm);
+    messagesRcvd.purgeExpired(simTime());
 
-    if (!isInsideROI(info) || !isMessageAlive(info)) {
-        return;
+    // Read in place: nothing is allocated for frames that are rejected
+    MessageInfoEntry info;
+    extractMsgInfo(wsm, info);
+
+    processMessage(wsm, info, true);
+
+    emit(messageObjectsPerFrame, frameObjects);
+}
+
+void Flooding::onBundle(WaveShortMessage* wsm) {
+    HotPathProfiler::Scope scope(profile.onBundle);
+
+    frameObjects = 0;
+
+    // The bundle drives the power adaptation like a single data frame
+    if (cfg.adaptTxPower)
+        adjustTxPower(wsm);
+
+    messagesRcvd.purgeExpired(simTime());
+
+    // Every record goes through the same checks as a message received in its own frame
+    const DataBundle* bundle = static_cast<const DataBundle*>(wsm->getEncapsulatedPacket());
+    bool designatedRelay = listsRelay(bundle, myId);
+    MessageInfoEntry info;
+
+    for (unsigned int i = 0; i < bundle->getRecordsArraySize(); i++) {
+        extractRecordInfo(bundle->getRecords(i), info);
+        info.designatedRelay = designatedRelay;
+        processMessage(wsm, info, false);
+    }
+
+    emit(messageObjectsPerFrame, frameObjects);
+}
+
+void Flooding::handleLowerMsg(cMessage* msg) {
+    // BaseWaveApplLayer only dispatches beacons and single data messages
+    if (strcmp(msg->getName(), "bundle") == 0) {
+        onBundle(static_cast<WaveShortMessage*>(msg));
+        delete msg;
+    } else {
+        BaseWaveApplLayer::handleLowerMsg(msg);
     }
+}
+
+void Flooding::processMessage(WaveShortMessage* wsm, MessageInfoEntry& info, bool payloadInFrame) {
+    if (!isInsideROI(&info) || !isMessageAlive(&info))
+        return;
 
-    if (!isDuplicateMsg(info->messageID)) {
+    if (!isDuplicateMsg(info.key())) {
         // Store message info
-        messagesRcvd[info->messageID] = info;
+        messagesRcvd.insert(info.key(), info.messageOriginTime + info.messageTTL);
+
+        if (resultsSink) {
+            resultsSink->append(ResultsFormat::RECEIVER, myId, info.eventID, info.receptionTime, info.messageID, info.messageLength,
+                    info.distanceToOrigin, info.hops);
+            resultsSink->recordReception(info.receptionTime - info.messageOriginTime, info.hops, info.distanceToOrigin);
+        }
+
         emit(messagesReceived, 1);
 
-        WaveShortMessage* wsm = createDataMsg(info);
-        sendWSM(wsm);
+        if (info.scf) {
+            emit(messagesReceivedSCF, 1);
+            info.scf = false;
+        }
+
+        if (broker && std::find(reportedEvents.begin(), reportedEvents.end(), info.eventID) == reportedEvents.end()) {
+            broker->reportReception(info.eventID, myId);
+            reportedEvents.push_back(info.eventID);
+        }
 
-        emit(messagesTransmitted, 1);
+        if (cfg.scfBufferSize > 0)
+            storeCarried(&info);
 
-        if (isCCHActive()) {
-            emit(sentDownMACInCCH, 1);
+        // The sender chose other neighbors to carry the message further
+        if (!info.designatedRelay) {
+            emit(notDesignatedRelay, 1);
+            return;
+        }
+
+        if (cfg.suppressionMode == SUPPRESSION_NONE) {
+            // The received payload is forwarded, so the message state is not copied
+            forwardMsg(&info, payloadInFrame ? static_cast<DataMessage*>(wsm->decapsulate()) : NULL);
+        } else {
+            scheduleForward(wsm, &info, wsm->getSenderPos().distance(curPosition), payloadInFrame);
         }
     } else {
         emit(duplicatedMessages, 1);
+
+        if (cfg.suppressionMode != SUPPRESSION_NONE) {
+            overhearCopy(info.key(), wsm->getSenderPos().distance(curPosition));
+        }
+    }
+}
+
+void Flooding::forwardMsg(MessageInfoEntry* info, DataMessage* payload) {
+    if (cfg.aggregationWindow > SIMTIME_ZERO) {
+        // Only the record of the message travels in the bundle
+        delete payload;
+        addToBundle(info);
+        emit(messagesTransmitted, 1);
+        return;
+    }
+
+    WaveShortMessage* wsm = createDataMsg(info, payload);
+    sendData(wsm);
+
+    emit(messagesTransmitted, 1);
+}
+
+void Flooding::sendData(WaveShortMessage* wsm) {
+    if (isCCHActive()) {
+        if (cfg.schAlignedForwarding) {
+            HeldFrame held;
+            held.wsm = wsm;
+            held.heldAt = simTime();
+            newlyHeldFrames.push_back(held);
+            return;
+        }
+
+        emit(sentDownMACInCCH, 1);
     }
+
+    sendWSM(wsm);
+}
+
+void Flooding::scheduleHeldFrames() {
+    // Spread the frames over the SCH interval instead of handing them all to the MAC at its start
+    for (std::vector<HeldFrame>::iterator i = newlyHeldFrames.begin(); i != newlyHeldFrames.end(); i++) {
+        i->releaseTime = simTime() + uniform(0, cfg.schSpreadWindow.dbl());
+        heldFrames.push_back(*i);
+    }
+    newlyHeldFrames.clear();
+
+    std::sort(heldFrames.begin(), heldFrames.end());
+
+    if (schReleaseTimer->isScheduled())
+        cancelEvent(schReleaseTimer);
+    scheduleAt(heldFrames.back().releaseTime, schReleaseTimer);
+}
+
+void Flooding::releaseHeldFrames() {
+    simtime_t now = simTime();
+
+    while (!heldFrames.empty() && heldFrames.back().releaseTime <= now) {
+        emit(forwardHoldTime, now - heldFrames.back().heldAt);
+        sendWSM(heldFrames.back().wsm);
+        heldFrames.pop_back();
+    }
+
+    if (!heldFrames.empty())
+        scheduleAt(heldFrames.back().releaseTime, schReleaseTimer);
+}
+
+void Flooding::scheduleForward(WaveShortMessage* wsm, MessageInfoEntry* info, double senderDistance, bool payloadInFrame) {
+    simtime_t backoff;
+
+    switch (cfg.suppressionMode) {
+        case SUPPRESSION_DISTANCE: {
+            // A copy from a nearby sender already covered almost all the area this node would cover
+            if (senderDistance < cfg.suppressionDistance) {
+                emit(rebroadcastsSuppressed, 1);
+                return;
+            }
+
+            // Nodes far from the sender cover more new area, so they wait less
+            double progress = std::min(senderDistance, cfg.suppressionRange) / cfg.suppressionRange;
+            backoff = cfg.suppressionMaxDelay * (1 - progress);
+            break;
+        }
+
+        case SUPPRESSION_GOSSIP: {
+            if (!bernoulli(cfg.gossipProbability)) {
+                emit(rebroadcastsSuppressed, 1);
+                return;
+            }
+            backoff = uniform(0, cfg.suppressionMaxDelay.dbl());
+            break;
+        }
+
+        default: {
+            backoff = uniform(0, cfg.suppressionMaxDelay.dbl());
+            break;
+        }
+    }
+
+    PendingForward& pending = pendingForwards[info->key()];
+    pending.info = *info;
+    pending.copies = 1;
+    pending.minSenderDistance = senderDistance;
+    // Kept until the rebroadcast or its cancellation
+    pending.payload = payloadInFrame ? static_cast<DataMessage*>(wsm->decapsulate()) : NULL;
+    pending.timer = new cMessage("rebroadcast", REBROADCAST_EVT);
+    pending.timer->setContextPointer(&pending);
+    frameObjects += 2; // Map node and timer
+
+    scheduleAt(simTime() + backoff, pending.timer);
+}
+
+void Flooding::overhearCopy(int64_t key, double senderDistance) {
+    std::map<int64_t, PendingForward>::iterator i = pendingForwards.find(key);
+
+    if (i == pendingForwards.end())
+        return;
+
+    PendingForward& pending = i->second;
+    pending.copies++;
+    pending.minSenderDistance = std::min(pending.minSenderDistance, senderDistance);
+
+    // Give up as soon as the rebroadcast is known to be redundant
+    if ((cfg.suppressionMode == SUPPRESSION_COUNTER && pending.copies >= cfg.suppressionCounterThreshold) ||
+            (cfg.suppressionMode == SUPPRESSION_DISTANCE && pending.minSenderDistance < cfg.suppressionDistance)) {
+        cancelAndDelete(pending.timer);
+        delete pending.payload;
+        pendingForwards.erase(i);
+
+        emit(rebroadcastsSuppressed, 1);
+    }
+}
+
+void Flooding::onForwardTimeout(PendingForward* pending) {
+    int64_t key = pending->info.key();
+
+    delete pending->timer;
+
+    // The message may have left the ROI or expired while waiting
+    if (isInsideROI(&pending->info) && isMessageAlive(&pending->info)) {
+        forwardMsg(&pending->info, pending->payload);
+    } else {
+        delete pending->payload;
+        emit(rebroadcastsSuppressed, 1);
+    }
+
+    pendingForwards.erase(key);
+}
+
+void Flooding::updateBeaconing() {
+    if (!beaconingEnabled)
+        return;
+
+    simtime_t startTime = beaconStartTime();
+    bool inRange = startTime != MAXTIME;
+
+    if (inRange && !sendBeaconEvt->isScheduled()) {
+        scheduleAt(nextBeaconTime(startTime), sendBeaconEvt);
+    } else if (!inRange && sendBeaconEvt->isScheduled()) {
+        cancelEvent(sendBeaconEvt);
+    }
+}
+
+simtime_t Flooding::beaconStartTime() {
+    // Three seconds before the first event that the vehicle is within ROI + 300 m of
+    if (broker) {
+        simtime_t eventStart = broker->firstEventNear(curPosition, 300);
+        return eventStart == MAXTIME ? MAXTIME : eventStart - 3;
+    }
+
+    return DisseminationBroker::isWithin(cfg.eventOrigin, cfg.beaconRange, curPosition) ? cfg.beaconStartTime : MAXTIME;
+}
+
+simtime_t Flooding::nextBeaconTime(simtime_t startTime) {
+    // First beacon time that is not in the past and comes after startTime
+    int64_t earliest = std::max(simTime().raw(), startTime.raw() + 1);
+    int64_t phase = beaconPhase.raw();
+    int64_t interval = cfg.beaconInterval.raw();
+
+    simtime_t next;
+    if (earliest <= phase)
+        next.setRaw(phase);
+    else
+        next.setRaw(phase + (earliest - phase + interval - 1) / interval * interval);
+
+    return next;
 }
 
 bool Flooding::isCCHActive() {
@@ -245,116 +622,358 @@ void Flooding::increaseTxPower() {
 
 }
 
-Flooding::MessageInfoEntry* Flooding::extractMsgInfo(WaveShortMessage* wsm) {
-    if (isDuplicateMsg(wsm->getSerial())) {
-        return messagesRcvd[wsm->getSerial()];
-    }
-    DataMessage* dataMsg = dynamic_cast<DataMessage*>(wsm->decapsulate());
+void Flooding::setTxPowerControl(WaveShortMessage* wsm) {
+    // Without power adaptation curTxPower is the MAC's own txPower, which the MAC uses when there is no control info
+    if (!cfg.adaptTxPower)
+        return;
 
-    MessageInfoEntry* info = new MessageInfoEntry;
+    PhyControlMessage *controlInfo = new PhyControlMessage();
+    controlInfo->setTxPower_mW(curTxPower);
+    wsm->setControlInfo(dynamic_cast<cObject *>(controlInfo));
+    frameObjects++;
+}
 
-    info->messageID = wsm->getSerial();
-    info->messageOriginPosition = dataMsg->getMessageOriginPosition();
-    info->messageROI = dataMsg->getMessageROI();
-    info->messageOriginTime = dataMsg->getMessageOriginTime();
-    info->messageTTL = dataMsg->getMessageTTL();
-    info->hops = dataMsg->getHops() + 1;
-    info->receptionTime = simTime();
-    info->messageLength = wsm->getByteLength();
-    info->distanceToOrigin = info->messageOriginPosition.distance(curPosition);
+void Flooding::extractMsgInfo(WaveShortMessage* wsm, MessageInfoEntry& info) {
+    // Data frames always carry a DataMessage. It is only read here; it stays in the frame unless it is forwarded.
+    const DataMessage* dataMsg = static_cast<const DataMessage*>(wsm->getEncapsulatedPacket());
+
+    info.eventID = dataMsg->getEventID();
+    info.messageID = wsm->getSerial();
+    info.messageOriginPosition = dataMsg->getMessageOriginPosition();
+    info.messageROI = dataMsg->getMessageROI();
+    info.messageOriginTime = dataMsg->getMessageOriginTime();
+    info.messageTTL = dataMsg->getMessageTTL();
+    info.hops = dataMsg->getHops() + 1;
+    info.receptionTime = simTime();
+    info.messageLength = wsm->getByteLength() - dataMsg->getByteLength();
+    info.distanceToOrigin = info.messageOriginPosition.distance(curPosition);
+    info.designatedRelay = listsRelay(dataMsg, myId);
+    info.scf = dataMsg->getScf();
+}
 
-    delete dataMsg;
+void Flooding::extractRecordInfo(const DataRecord& record, MessageInfoEntry& info) {
+    info.eventID = record.eventID;
+    info.messageID = record.messageID;
+    info.messageOriginPosition = record.messageOriginPosition;
+    info.messageROI = record.messageROI;
+    info.messageOriginTime = record.messageOriginTime;
+    info.messageTTL = record.messageTTL;
+    info.hops = record.hops + 1;
+    info.receptionTime = simTime();
+    info.messageLength = record.messageLength;
+    info.distanceToOrigin = info.messageOriginPosition.distance(curPosition);
+    info.designatedRelay = true;
+    info.scf = record.scf;
+}
 
-    return info;
+bool Flooding::isDuplicateMsg(int64_t key) {
+    return messagesRcvd.contains(key);
 }
 
-bool Flooding::isDuplicateMsg(int messageID) {
-    return messagesRcvd.find(messageID) != messagesRcvd.end();
+void Flooding::selectRelays(std::vector<int>& relays) {
+    relays.clear();
+
+    if (cfg.relaySelection == RELAY_ALL)
+        return;
+
+    neighbors.purgeExpired(simTime());
+
+    if (cfg.relaySelection == RELAY_FARTHEST)
+        neighbors.selectFarthest(curPosition, cfg.relayCount, relayCandidates, relays);
+    else
+        neighbors.selectBySector(curPosition, cfg.relayCount, relayCandidates, relays);
 }
 
 bool Flooding::isInsideROI(MessageInfoEntry* info) {
-    return info->messageOriginPosition.distance(curPosition) < info->messageROI;
+    return DisseminationBroker::isWithin(info->messageOriginPosition, info->messageROI, curPosition);
 }
 
 bool Flooding::isMessageAlive(MessageInfoEntry* info) {
     return simTime() < info->messageOriginTime + info->messageTTL;
 }
 
-WaveShortMessage* Flooding::createDataMsg(MessageInfoEntry* info) {
+WaveShortMessage* Flooding::createDataMsg(MessageInfoEntry* info, DataMessage* payload) {
     WaveShortMessage* wsm = prepareWSM("data", dataLengthBits, type_SCH, dataPriority, 0, info->messageID);
+    frameObjects++;
 
     //TODO: Added for Game Theory Solution
-    PhyControlMessage *controlInfo = new PhyControlMessage();
-    controlInfo->setTxPower_mW(curTxPower);
-    wsm->setControlInfo(dynamic_cast<cObject *>(controlInfo));
+    setTxPowerControl(wsm);
+
+    // Messages received in a bundle have no DataMessage of their own
+    if (!payload) {
+        payload = new DataMessage("data");
+        payload->setEventID(info->eventID);
+        payload->setMessageOriginPosition(info->messageOriginPosition);
+        payload->setMessageROI(info->messageROI);
+        payload->setMessageOriginTime(info->messageOriginTime);
+        payload->setMessageTTL(info->messageTTL);
+        frameObjects++;
+    }
 
-    DataMessage* msg = new DataMessage("data");
+    // Origin, ROI, origin time and TTL never change along the path
+    payload->setHops(info->hops);
+    payload->setScf(info->scf);
 
-    msg->setMessageOriginPosition(info->messageOriginPosition);
-    msg->setMessageROI(info->messageROI);
-    msg->setMessageOriginTime(info->messageOriginTime);
-    msg->setMessageTTL(info->messageTTL);
-    msg->setHops(info->hops);
+    // Without known neighbors the list stays empty and every receiver may rebroadcast
+    selectRelays(relayBuffer);
+    setRelays(payload, relayBuffer);
 
     wsm->setByteLength(info->messageLength);
 
-    wsm->encapsulate(msg);
+    wsm->encapsulate(payload);
 
     return wsm;
 }
 
-void Flooding::processBackTraffic(int senderAddr) {
-    if (lastRequesters.find(senderAddr) == lastRequesters.end()) {
-        // Send 60 packets of 1000 bytes on the Service Channel
-        for (int i = 0; i < 60; i++) {
-            WaveShortMessage* wsm = prepareWSM("back traffic", dataLengthBits, type_SCH, dataPriority, 0, i);
-            wsm->setByteLength(1000);
+void Flooding::addToBundle(MessageInfoEntry* info) {
+    // A message that does not fit in the pending bundle starts a new one
+    if (!bundleRecords.empty() && bundleBytes + info->messageLength > cfg.aggregationMaxBytes)
+        sendBundle();
+
+    DataRecord record;
+    record.eventID = info->eventID;
+    record.messageID = info->messageID;
+    record.messageLength = info->messageLength;
+    record.messageOriginPosition = info->messageOriginPosition;
+    record.messageROI = info->messageROI;
+    record.messageOriginTime = info->messageOriginTime;
+    record.messageTTL = info->messageTTL;
+    record.hops = info->hops;
+    record.scf = info->scf;
+
+    bundleRecords.push_back(record);
+    bundleBytes += info->messageLength;
+
+    if (bundleBytes >= cfg.aggregationMaxBytes)
+        sendBundle();
+    else if (!aggregationTimer->isScheduled())
+        scheduleAt(simTime() + cfg.aggregationWindow, aggregationTimer);
+}
+
+void Flooding::sendBundle() {
+    if (aggregationTimer->isScheduled())
+        cancelEvent(aggregationTimer);
+
+    if (bundleRecords.empty())
+        return;
+
+    WaveShortMessage* wsm = prepareWSM("bundle", dataLengthBits, type_SCH, dataPriority, 0, bundleRecords.front().messageID);
+    frameObjects++;
+
+    setTxPowerControl(wsm);
+
+    DataBundle* bundle = new DataBundle("bundle");
+    frameObjects++;
+    bundle->setRecordsArraySize(bundleRecords.size());
+    for (unsigned int i = 0; i < bundleRecords.size(); i++)
+        bundle->setRecords(i, bundleRecords[i]);
+
+    selectRelays(relayBuffer);
+    setRelays(bundle, relayBuffer);
+
+    // The frame is as long as the messages it carries, as if they had been sent one by one
+    wsm->setByteLength(bundleBytes);
+    wsm->encapsulate(bundle);
 
-            sendWSM(wsm);
+    sendData(wsm);
+
+    emit(bundlesTransmitted, 1);
+
+    bundleRecords.clear();
+    bundleBytes = 0;
+}
+
+void Flooding::storeCarried(MessageInfoEntry* info) {
+    simtime_t now = simTime();
+
+    if ((int) carriedMessages.size() >= cfg.scfBufferSize)
+        evictCarried(now);
+
+    CarriedMessage carried;
+    carried.info = *info;
+    carried.storedAt = now;
+    carried.lastForward = now;
+    carriedMessages.push_back(carried);
+}
+
+void Flooding::evictCarried(simtime_t now) {
+    std::vector<CarriedMessage>::iterator last = carriedMessages.begin();
+
+    // Expired messages go first, whatever the policy
+    for (std::vector<CarriedMessage>::iterator i = carriedMessages.begin(); i != carriedMessages.end(); i++) {
+        if (isMessageAlive(&i->info))
+            *last++ = *i;
+    }
+    carriedMessages.erase(last, carriedMessages.end());
+
+    if ((int) carriedMessages.size() < cfg.scfBufferSize)
+        return;
+
+    std::vector<CarriedMessage>::iterator victim = carriedMessages.begin();
+
+    for (std::vector<CarriedMessage>::iterator i = carriedMessages.begin(); i != carriedMessages.end(); i++) {
+        switch (cfg.scfEviction) {
+            case SCF_EVICT_OLDEST:
+                if (i->storedAt < victim->storedAt)
+                    victim = i;
+                break;
+
+            case SCF_EVICT_EXPIRING:
+                if (i->info.messageOriginTime + i->info.messageTTL < victim->info.messageOriginTime + victim->info.messageTTL)
+                    victim = i;
+                break;
+
+            case SCF_EVICT_HOPS:
+                if (i->info.hops > victim->info.hops)
+                    victim = i;
+                break;
         }
+    }
+
+    carriedMessages.erase(victim);
+}
+
+void Flooding::forwardCarried() {
+    simtime_t now = simTime();
+    std::vector<CarriedMessage>::iterator last = carriedMessages.begin();
+
+    for (std::vector<CarriedMessage>::iterator i = carriedMessages.begin(); i != carriedMessages.end(); i++) {
+        if (!isMessageAlive(&i->info))
+            continue;
+
+        // Only sent inside the ROI, but kept in case the vehicle comes back to it
+        if (isInsideROI(&i->info) && now >= i->lastForward + cfg.scfRetryInterval) {
+            MessageInfoEntry info = i->info;
+            info.scf = true;
+            forwardMsg(&info, NULL);
+
+            emit(messagesTransmittedSCF, 1);
+            i->lastForward = now;
+        }
+
+        *last++ = *i;
+    }
+
+    carriedMessages.erase(last, carriedMessages.end());
+}
+
+void Flooding::sendWSM(WaveShortMessage* wsm) {
+    if (profile.sendWSM)
+        profile.sendWSM->addFrame(wsm->getByteLength(), HotPathProfiler::estimateMacQueue(mac, framesHandedDown));
+
+    framesHandedDown++;
+
+    BaseWaveApplLayer::sendWSM(wsm);
+}
+
+void Flooding::initProfile() {
+    HotPathProfiler* profiler = HotPathProfiler::get();
+    if (!profiler)
+        return;
 
-        NeighborEntry* entry = new NeighborEntry;
+    std::string type = getNedTypeName();
+
+    profile.selfMsg[SEND_BEACON_EVT - SEND_BEACON_EVT] = profiler->getHandler(type, "handleSelfMsg(beacon)");
+    profile.selfMsg[BACK_TRAFFIC_ENTRY_TIMEOUT - SEND_BEACON_EVT] = profiler->getHandler(type, "handleSelfMsg(backTrafficEntryTimeout)");
+    profile.selfMsg[BACK_TRAFFIC_SEND - SEND_BEACON_EVT] = profiler->getHandler(type, "handleSelfMsg(backTrafficSend)");
+    profile.selfMsg[REBROADCAST_EVT - SEND_BEACON_EVT] = profiler->getHandler(type, "handleSelfMsg(rebroadcast)");
+    profile.selfMsg[AGGREGATION_FLUSH - SEND_BEACON_EVT] = profiler->getHandler(type, "handleSelfMsg(aggregationFlush)");
+    profile.selfMsg[SCH_RELEASE - SEND_BEACON_EVT] = profiler->getHandler(type, "handleSelfMsg(schRelease)");
+    profile.onBeacon = profiler->getHandler(type, "onBeacon");
+    profile.onData = profiler->getHandler(type, "onData");
+    profile.onBundle = profiler->getHandler(type, "onBundle");
+    profile.receiveSignal = profiler->getHandler(type, "receiveSignal");
+    profile.channelInterval = profiler->getHandler(type, "receiveSignal(channelInterval)");
+    profile.sendWSM = profiler->getHandler(type, "sendWSM");
+}
+
+void Flooding::processBackTraffic(int senderAddr) {
+    if (!backTraffic.admit(senderAddr, simTime() + cfg.backTrafficHoldTime))
+        return;
 
-        entry->beaconHoldTimer = new cMessage("beacon entry timeout", BACK_TRAFFIC_ENTRY_TIMEOUT);
-        entry->beaconHoldTimer->setContextPointer((NeighborEntry*) entry);
-        scheduleAt(simTime() + 3, entry->beaconHoldTimer);
+    if (!backTrafficEntryTimer->isScheduled())
+        scheduleAt(backTraffic.nextExpiry(), backTrafficEntryTimer);
 
-        lastRequesters[senderAddr] = entry;
+    backTraffic.addPackets(cfg.backTrafficBurstSize);
+
+    // Without pacing the whole burst goes down to the MAC (Service Channel) at once
+    if (cfg.backTrafficInterval == SIMTIME_ZERO) {
+        while (backTraffic.getPendingPackets() > 0)
+            sendBackTrafficPacket();
+    } else if (!backTrafficSendTimer->isScheduled()) {
+        scheduleAt(simTime(), backTrafficSendTimer);
     }
 }
 
+void Flooding::sendBackTrafficPacket() {
+    if (!backTrafficPrototype) {
+        backTrafficPrototype = prepareWSM("back traffic", dataLengthBits, type_SCH, dataPriority, 0, 0);
+        backTrafficPrototype->setByteLength(cfg.backTrafficPacketSize);
+    }
+
+    // The MAC takes ownership of what is sent, so packets are copies of the prototype with the per-packet fields updated
+    WaveShortMessage* wsm = backTrafficPrototype->dup();
+    wsm->setSerial(backTrafficSerial++ % cfg.backTrafficBurstSize);
+    wsm->setSenderPos(curPosition);
+    wsm->setTimestamp(simTime());
+
+    sendWSM(wsm);
+
+    backTraffic.removePacket();
+}
+
 void Flooding::receiveSignal(cComponent* source, simsignal_t signalID, cObject* obj, cObject* details) {
     Enter_Method_Silent();
+    HotPathProfiler::Scope scope(profile.receiveSignal);
+
     BaseWaveApplLayer::receiveSignal(source, signalID, obj, details);
 
-    if (signalID == mobilityStateChangedSignal) {
-        Coord rsuPosition = Coord(par("eventOriginX").doubleValue(), par("eventOriginY").doubleValue(), par("eventOriginZ").doubleValue());
+    if (signalID != mobilityStateChangedSignal)
+        return;
 
-        if (disseminationStarted && curPosition.distance(rsuPosition) <= par("dataROI").doubleValue() &&
-                ((simTime() >= disseminationStartTime) && (simTime() <= (disseminationStartTime + par("dataTTL").doubleValue())))) {
-            wasInROI = true;
-        }
+    // The broker decides whether the vehicle is inside the ROI of the event
+    if (broker) {
+        if (brokerHandle < 0)
+            brokerHandle = broker->addVehicle(myId, curPosition);
+        else
+            broker->updateVehicle(brokerHandle, curPosition);
     }
+
+    updateBeaconing();
 }
 
-void Flooding::receiveSignal(cComponent *source, simsignal_t signalID, const SimTime& t) {
+void Flooding::receiveSignal(cComponent* source, simsignal_t signalID, long value, cObject* details) {
     Enter_Method_Silent();
+    HotPathProfiler::Scope scope(profile.channelInterval);
+
+    if (signalID != ChannelIntervalClock::intervalStartSignal)
+        return;
 
-    if (!strcmp(getSignalName(signalID), "disseminationStartTime")) {
-        disseminationStarted = true;
-        disseminationStartTime = simTime();
-        Coord rsuPosition = Coord(par("eventOriginX").doubleValue(), par("eventOriginY").doubleValue(), par("eventOriginZ").doubleValue());
+    // Only the collisions between the start of an SCH interval and the start of the next CCH interval are counted
+    if (value == ChannelIntervalClock::CCH_INTERVAL) {
+        totalCollisions = totalCollisions + mac->statsTXRXLostPackets - lastNumCollisions;
+    } else {
+        lastNumCollisions = mac->statsTXRXLostPackets;
 
-        if (curPosition.distance(rsuPosition) <= par("dataROI").doubleValue())
-            wasInROI = true;
+        if (!newlyHeldFrames.empty())
+            scheduleHeldFrames();
     }
 }
 
 Flooding::~Flooding() {
-    for (std::map<int, NeighborEntry*>::iterator i = lastRequesters.begin(); i != lastRequesters.end(); i++) {
-        NeighborEntry* entry = i->second;
-        cancelAndDelete(entry->beaconHoldTimer);
+    cancelAndDelete(backTrafficEntryTimer);
+    cancelAndDelete(backTrafficSendTimer);
+    delete backTrafficPrototype;
+
+    for (std::map<int64_t, PendingForward>::iterator i = pendingForwards.begin(); i != pendingForwards.end(); i++) {
+        cancelAndDelete(i->second.timer);
+        delete i->second.payload;
     }
-    cancelAndDelete(CCHStartTimer);
-    cancelAndDelete(SCHStartTimer);
+    cancelAndDelete(aggregationTimer);
+
+    for (std::vector<HeldFrame>::iterator i = newlyHeldFrames.begin(); i != newlyHeldFrames.end(); i++)
+        delete i->wsm;
+    for (std::vector<HeldFrame>::iterator i = heldFrames.begin(); i != heldFrames.end(); i++)
+        delete i->wsm;
+    cancelAndDelete(schReleaseTimer);
 }
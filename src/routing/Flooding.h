@@ -19,8 +19,15 @@
 #include "BaseWaveApplLayer.h"
 #include "WaveShortMessage_m.h"
 #include "DataMessage_m.h"
-#include "TraCIMobility.h"
+#include "BackTrafficGenerator.h"
+#include "ChannelIntervalClock.h"
+#include "DisseminationBroker.h"
+#include "DuplicateTable.h"
+#include "NeighborTable.h"
+#include "HotPathProfiler.h"
+#include "ResultsSink.h"
 #include <algorithm>
+#include <vector>
 
 #include "FindModule.h"
 #include "Mac1609_4.h"
@@ -31,17 +38,15 @@
 
 class Flooding : public BaseWaveApplLayer
 {
-protected:
-
-    struct NeighborEntry {
-        int senderAddress;
-        Coord position; // Neighbor position
+public:
+    // Identifies a message across all the dissemination events
+    static int64_t messageKey(int eventID, int messageID) { return ((int64_t) eventID << 32) | (uint32_t) messageID; }
 
-        cMessage* beaconHoldTimer;
-    };
+protected:
 
     struct MessageInfoEntry {
-        int messageID; // Message unique ID
+        int eventID; // Dissemination event of the message
+        int messageID; // Message ID, unique within its event
 
         Coord messageOriginPosition; // Message origin
         double messageROI; // Region of Interest in meters
@@ -52,67 +57,259 @@ protected:
         simtime_t receptionTime;
         int messageLength;
         double distanceToOrigin;
+        bool designatedRelay; // Whether the sender left the rebroadcast to this host (or to any receiver)
+        bool scf; // Whether the message is (or was received) sent again from a store-carry-forward buffer
+
+        int64_t key() const { return messageKey(eventID, messageID); }
+    };
+
+    // Policies used to make room in a full store-carry-forward buffer
+    enum ScfEviction {
+        SCF_EVICT_OLDEST, // The message stored first
+        SCF_EVICT_EXPIRING, // The message closest to the end of its TTL
+        SCF_EVICT_HOPS, // The message with the most hops
+    };
+
+    // Message kept for store-carry-forward
+    struct CarriedMessage {
+        MessageInfoEntry info;
+        simtime_t storedAt;
+        simtime_t lastForward; // Last time it was sent, from the buffer or not
+    };
+
+    // Schemes used to decide whether a received message is rebroadcast
+    enum SuppressionMode {
+        SUPPRESSION_NONE, // Blind flooding: every new message is rebroadcast immediately
+        SUPPRESSION_COUNTER, // Wait a random backoff and rebroadcast only if less than suppressionCounterThreshold copies were overheard
+        SUPPRESSION_DISTANCE, // Wait less the farther the sender is, and rebroadcast only if no copy came from closer than suppressionDistance
+        SUPPRESSION_GOSSIP, // Rebroadcast with probability gossipProbability after a random backoff
+    };
+
+    // Schemes used by a sender to choose the neighbors that rebroadcast what it sends
+    enum RelaySelection {
+        RELAY_ALL, // No selection: every receiver may rebroadcast
+        RELAY_FARTHEST, // The relayCount neighbors farthest from the sender
+        RELAY_SECTORS, // The farthest neighbor in each of relayCount sectors around the sender
+    };
+
+    // Data frame held until the SCH interval
+    struct HeldFrame {
+        WaveShortMessage* wsm;
+        simtime_t heldAt;
+        simtime_t releaseTime; // Drawn when the SCH interval starts
+
+        // Latest release first, so that the next frame due is at the back
+        bool operator<(const HeldFrame& other) const { return releaseTime > other.releaseTime; }
+    };
+
+    // Rebroadcast waiting for its backoff to expire
+    struct PendingForward {
+        MessageInfoEntry info;
+        int copies; // Copies overheard, including the first one
+        double minSenderDistance; // Distance to the closest sender a copy was overheard from
+        DataMessage* payload; // Payload of the first copy, forwarded as is
+        cMessage* timer;
+    };
+
+    // Parameters used by the per-packet and per-update handlers. They are read once in initialize() and never
+    // modified afterwards, so the handlers do not have to look parameters up by name.
+    struct Config {
+        // Event used for the beacon range when there is no DisseminationBroker. Otherwise the events are the ones
+        // the RSUs register with the broker.
+        Coord eventOrigin; // Event (RSU) position
+        double dataROI;
+        double beaconRange; // Distance to the event below which a vehicle sends beacons (ROI + 300 m)
+        simtime_t startDataProductionTime;
+        simtime_t beaconStartTime; // Beacons are only sent from three seconds before the dissemination
+        simtime_t beaconInterval;
+        bool adaptTxPower;
+        bool generateBackTraffic;
+        int backTrafficBurstSize;
+        int backTrafficPacketSize; // bytes
+        simtime_t backTrafficInterval; // Gap between two back-traffic packets. Zero sends the whole burst at once
+        simtime_t backTrafficHoldTime;
+        SuppressionMode suppressionMode;
+        int suppressionCounterThreshold;
+        double suppressionDistance;
+        double suppressionRange; // Transmission range used to scale the distance-based backoff
+        simtime_t suppressionMaxDelay;
+        double gossipProbability;
+        RelaySelection relaySelection;
+        int relayCount;
+        int scfBufferSize; // Zero disables store-carry-forward
+        ScfEviction scfEviction;
+        simtime_t scfRetryInterval; // A carried message is not sent again sooner than this
+        simtime_t aggregationWindow; // Zero sends every forwarded message in its own frame
+        int aggregationMaxBytes; // Largest bundle, in bytes of message payload
+        bool schAlignedForwarding; // Data frames produced during the CCH interval wait for the next SCH interval
+        simtime_t schSpreadWindow; // Held frames are released at random within this time from the SCH start
     };
 
     enum {
         BACK_TRAFFIC_ENTRY_TIMEOUT = SEND_BEACON_EVT + 1,
-        CCH_START,
-        SCH_START,
+        BACK_TRAFFIC_SEND,
+        REBROADCAST_EVT,
+        AGGREGATION_FLUSH,
+        SCH_RELEASE,
     };
 
+    // Hot-path profiling entries, shared by all the Flooding hosts. All NULL unless the HotPathProfiler is enabled.
+    struct Profile {
+        HotPathProfiler::Handler* selfMsg[SCH_RELEASE - SEND_BEACON_EVT + 1]; // By message kind
+        HotPathProfiler::Handler* onBeacon;
+        HotPathProfiler::Handler* onData;
+        HotPathProfiler::Handler* onBundle;
+        HotPathProfiler::Handler* receiveSignal;
+        HotPathProfiler::Handler* channelInterval;
+        HotPathProfiler::Handler* sendWSM; // Frames handed to the MAC
+
+        Profile() : onBeacon(NULL), onData(NULL), onBundle(NULL), receiveSignal(NULL), channelInterval(NULL), sendWSM(NULL) {
+            std::fill(selfMsg, selfMsg + SCH_RELEASE - SEND_BEACON_EVT + 1, (HotPathProfiler::Handler*) NULL);
+        }
+    };
+
+    Config cfg;
+
+    Profile profile;
+
+    // Beacons are only scheduled while the vehicle is inside the beacon range of the event. They are sent at
+    // beaconPhase + k * beaconInterval, beaconPhase being the first beacon time drawn by BaseWaveApplLayer.
+    bool beaconingEnabled;
+    simtime_t beaconPhase;
+
+    // Frames handed to the MAC so far, used to estimate the MAC queue length
+    long framesHandedDown;
+
+    // Message objects (frames, payloads, control infos, rebroadcast timers and their map nodes) created while
+    // handling the current received frame. Not a count of all heap allocations: container growth is left out.
+    int frameObjects;
+
     //TODO: Added for Game theory Solution
     double curTxPower;
     int powerLevel;
     double myUtilityValue;
 
-    bool wasInROI;
+    // Owner of the event metadata and of the ROI membership of the vehicles
+    DisseminationBroker* broker;
 
-    bool disseminationStarted;
+    // Handle of this vehicle in the broker, -1 until its first position is reported
+    int brokerHandle;
 
-    simtime_t disseminationStartTime;
+    // Events for which the broker already knows this vehicle received a message
+    std::vector<int> reportedEvents;
 
     Mac1609_4* mac;
 
-    cMessage* CCHStartTimer;
-
-    cMessage* SCHStartTimer;
+    // Notifies the start of every CCH and SCH interval. Collisions are only counted if it is present
+    ChannelIntervalClock* channelClock;
 
+    // MAC collision count at the start of the current SCH interval
     long lastNumCollisions;
 
+    // Collisions during the SCH intervals
     long totalCollisions;
 
     static const simsignalwrap_t mobilityStateChangedSignal;
 
-    Veins::TraCIMobility* traci;
+    // Used by the back-traffic application. Every time a node receives a beacon from a node that has not requested traffic in the
+    // last backTrafficHoldTime, then it transmits a burst of backTrafficBurstSize packets of backTrafficPacketSize. This simulates other
+    // applications sharing the channel with the primary data dissemination.
+    BackTrafficGenerator backTraffic;
+
+    // Expiry of the oldest back-traffic requester
+    cMessage* backTrafficEntryTimer;
+
+    // Paces the packets of the pending bursts
+    cMessage* backTrafficSendTimer;
+
+    // Back-traffic packets are copies of this message, built on the first burst
+    WaveShortMessage* backTrafficPrototype;
+
+    long backTrafficSerial;
+
+    // Beacon senders heard within the last neighborHoldTime, used to choose the relays
+    NeighborTable neighbors;
+
+    // Messages carried for store-carry-forward, at most cfg.scfBufferSize
+    std::vector<CarriedMessage> carriedMessages;
+
+    // Relays chosen for the frame being built and the neighbors considered for them. Kept as members so that
+    // their storage is reused
+    std::vector<int> relayBuffer;
+    NeighborTable::Candidates relayCandidates;
+
+    // IDs of the messages accepted so far. Entries are evicted once the message TTL has expired
+    DuplicateTable messagesRcvd;
+
+    // Rebroadcasts waiting for their backoff, by message key
+    std::map<int64_t, PendingForward> pendingForwards;
+
+    // Messages waiting to be forwarded in the next bundle, and their total length in bytes
+    std::vector<DataRecord> bundleRecords;
+    int bundleBytes;
+
+    // Sends the pending bundle once the aggregation window has passed since its first message
+    cMessage* aggregationTimer;
 
-    // Used by the back-traffic application. Every time a node receives a beacon that has not been received in the last 3 seconds, then
-    // it stores the info about the transmitter of the beacon and transmits 60 packets of 1000B. This simulates other applications
-    // sharing the channel with the primary data dissemination.
-    std::map<int, NeighborEntry*> lastRequesters;
+    // Data frames held during the current CCH interval, without a release time yet
+    std::vector<HeldFrame> newlyHeldFrames;
+    // Data frames with a release time, sorted by release time, latest first; schReleaseTimer fires at the
+    // release time of the last one
+    std::vector<HeldFrame> heldFrames;
+    cMessage* schReleaseTimer;
 
-    std::map<int, MessageInfoEntry*> messagesRcvd;
+    // Receiver log of all hosts
+    ResultsSink* resultsSink;
 
     virtual void initialize(int stage);
     virtual void finish();
     virtual void handleSelfMsg(cMessage* msg);
     virtual void onBeacon(WaveShortMessage* wsm);
     virtual void onData(WaveShortMessage* wsm);
+    virtual void onBundle(WaveShortMessage* wsm);
+    virtual void handleLowerMsg(cMessage* msg);
     virtual bool isCCHActive();
+    virtual void updateBeaconing();
+    virtual simtime_t beaconStartTime();
+    virtual simtime_t nextBeaconTime(simtime_t startTime);
 
     //TODO: Added for Game theory Solution
     virtual void adjustTxPower(WaveShortMessage* wsm);
     virtual void decreaseTxPower();
     virtual void increaseTxPower();
+    // Gives the MAC the transmission power of the power adaptation for the frame
+    virtual void setTxPowerControl(WaveShortMessage* wsm);
 
-    virtual MessageInfoEntry* extractMsgInfo(WaveShortMessage* wsm);
-    virtual bool isDuplicateMsg(int messageID);
+    virtual void extractMsgInfo(WaveShortMessage* wsm, MessageInfoEntry& info);
+    virtual void extractRecordInfo(const DataRecord& record, MessageInfoEntry& info);
+    // Duplicate, ROI and TTL checks of a received message. If payloadInFrame, wsm carries the message as its
+    // DataMessage, which is forwarded as is; otherwise a new DataMessage is built if the message is forwarded.
+    virtual void processMessage(WaveShortMessage* wsm, MessageInfoEntry& info, bool payloadInFrame);
+    virtual bool isDuplicateMsg(int64_t key);
+    virtual void selectRelays(std::vector<int>& relays);
     virtual bool isInsideROI(MessageInfoEntry* info);
     virtual bool isMessageAlive(MessageInfoEntry* info);
-    virtual WaveShortMessage* createDataMsg(MessageInfoEntry* info);
+    // Builds the frame that forwards payload, taking ownership of it. A NULL payload is built from info.
+    virtual WaveShortMessage* createDataMsg(MessageInfoEntry* info, DataMessage* payload);
+    virtual void forwardMsg(MessageInfoEntry* info, DataMessage* payload);
+    virtual void scheduleForward(WaveShortMessage* wsm, MessageInfoEntry* info, double senderDistance, bool payloadInFrame);
+    virtual void addToBundle(MessageInfoEntry* info);
+    virtual void sendBundle();
+    virtual void sendData(WaveShortMessage* wsm);
+    virtual void scheduleHeldFrames();
+    virtual void releaseHeldFrames();
+    virtual void storeCarried(MessageInfoEntry* info);
+    virtual void evictCarried(simtime_t now);
+    virtual void forwardCarried();
+    virtual void overhearCopy(int64_t key, double senderDistance);
+    virtual void onForwardTimeout(PendingForward* pending);
+    virtual void sendWSM(WaveShortMessage* wsm);
+    virtual void initProfile();
     virtual void processBackTraffic(int senderAddr);
+    virtual void sendBackTrafficPacket();
 
     virtual void receiveSignal(cComponent* source, simsignal_t signalID, cObject* obj, cObject* details);
-    virtual void receiveSignal(cComponent *source, simsignal_t signalID, const SimTime& t);
+    virtual void receiveSignal(cComponent* source, simsignal_t signalID, long value, cObject* details);
 
 public:
     //TODO: Added for Game theory Solution
@@ -123,8 +320,15 @@ public:
     simsignal_t collisions; // Indicate the total number of collisions
     simsignal_t duplicatedMessages; // Indicate the number of duplicate messages received by a vehicle
     simsignal_t messagesTransmitted; // Indicate the number of messages transmitted by a vehicle
+    simsignal_t bundlesTransmitted; // Indicate the number of frames sent carrying several messages
+    simsignal_t rebroadcastsSuppressed; // Indicate the number of rebroadcasts cancelled by the suppression scheme
+    simsignal_t notDesignatedRelay; // Indicate the number of new messages not rebroadcast because the sender chose other relays
     simsignal_t messagesReceived; // Indicate whether the message was received or not
-    simsignal_t isInROI; // Indicate whether the vehicle is inside the ROI at the time the dissemination starts
+    simsignal_t isInROI; // Indicate whether the vehicle was inside the ROI while the dissemination was active
+    simsignal_t messageObjectsPerFrame; // Indicate the number of message objects created to handle a received data frame
+    simsignal_t messagesTransmittedSCF; // Indicate the number of messages sent again from the store-carry-forward buffer
+    simsignal_t messagesReceivedSCF; // Indicate the number of new messages received from a store-carry-forward buffer
+    simsignal_t forwardHoldTime; // Indicate the time a data frame was held waiting for the SCH interval
 
     virtual ~Flooding();
 };
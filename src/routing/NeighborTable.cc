@@ -0,0 +1,97 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "NeighborTable.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool NeighborTable::update(int address, const Coord& position, simtime_t now) {
+    simtime_t expiry = now + holdTime;
+
+    for (std::vector<Entry>::iterator i = entries.begin(); i != entries.end(); i++) {
+        if (i->address == address) {
+            i->position = position;
+            i->expiry = expiry;
+            return false;
+        }
+    }
+
+    Entry entry;
+    entry.address = address;
+    entry.position = position;
+    entry.expiry = expiry;
+    entries.push_back(entry);
+
+    if (expiry < earliestExpiry)
+        earliestExpiry = expiry;
+
+    return true;
+}
+
+void NeighborTable::purgeExpired(simtime_t now) {
+    if (entries.empty() || now < earliestExpiry)
+        return;
+
+    earliestExpiry = MAXTIME;
+
+    std::vector<Entry>::iterator last = entries.begin();
+    for (std::vector<Entry>::iterator i = entries.begin(); i != entries.end(); i++) {
+        if (i->expiry <= now)
+            continue;
+
+        *last++ = *i;
+
+        if (i->expiry < earliestExpiry)
+            earliestExpiry = i->expiry;
+    }
+
+    entries.erase(last, entries.end());
+}
+
+void NeighborTable::selectFarthest(const Coord& position, int count, Candidates& candidates, std::vector<int>& relays) const {
+    candidates.clear();
+
+    for (std::vector<Entry>::const_iterator i = entries.begin(); i != entries.end(); i++)
+        candidates.push_back(std::make_pair(-i->position.sqrdist(position), i->address));
+
+    size_t selected = std::min(candidates.size(), (size_t) std::max(count, 0));
+    std::partial_sort(candidates.begin(), candidates.begin() + selected, candidates.end());
+
+    for (size_t i = 0; i < selected; i++)
+        relays.push_back(candidates[i].second);
+}
+
+void NeighborTable::selectBySector(const Coord& position, int sectors, Candidates& farthest, std::vector<int>& relays) const {
+    if (sectors <= 0)
+        return;
+
+    // Farthest neighbor of every sector, as squared distance and address
+    farthest.assign(sectors, std::make_pair(-1.0, 0));
+
+    for (std::vector<Entry>::const_iterator i = entries.begin(); i != entries.end(); i++) {
+        double angle = atan2(i->position.y - position.y, i->position.x - position.x) + M_PI;
+        int sector = std::min((int) (angle / (2 * M_PI) * sectors), sectors - 1);
+        double sqrDistance = i->position.sqrdist(position);
+
+        if (sqrDistance > farthest[sector].first)
+            farthest[sector] = std::make_pair(sqrDistance, i->address);
+    }
+
+    for (int i = 0; i < sectors; i++) {
+        if (farthest[i].first >= 0)
+            relays.push_back(farthest[i].second);
+    }
+}
@@ -0,0 +1,66 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __FLOODING_NEIGHBORTABLE_H_
+#define __FLOODING_NEIGHBORTABLE_H_
+
+#include <omnetpp.h>
+#include <utility>
+#include <vector>
+
+#include "Coord.h"
+
+// Last known position of the hosts heard through beacons. Entries are kept in a flat vector, which is small
+// (one entry per host in radio range) and scanned linearly, and are dropped holdTime after the last beacon
+// of their host.
+class NeighborTable
+{
+public:
+    // Squared distance and address of the neighbors considered by a selection
+    typedef std::vector<std::pair<double, int> > Candidates;
+
+    NeighborTable() : holdTime(0), earliestExpiry(MAXTIME) {}
+
+    void setHoldTime(simtime_t time) { holdTime = time; }
+
+    // Adds the sender of a beacon or refreshes its position. Returns true if the sender was not in the table.
+    bool update(int address, const Coord& position, simtime_t now);
+
+    // Drops the neighbors not heard from within the hold time. Cheap to call when nothing has expired.
+    void purgeExpired(simtime_t now);
+
+    size_t size() const { return entries.size(); }
+
+    // Appends to relays the count neighbors farthest from position, farthest first. candidates is working
+    // storage owned by the caller, so that a selection per forwarded message does not allocate.
+    void selectFarthest(const Coord& position, int count, Candidates& candidates, std::vector<int>& relays) const;
+
+    // Splits the plane around position in sectors equal angular sectors and appends to relays the farthest
+    // neighbor of every non-empty sector. candidates is working storage, as for selectFarthest.
+    void selectBySector(const Coord& position, int sectors, Candidates& candidates, std::vector<int>& relays) const;
+
+private:
+    struct Entry {
+        int address;
+        Coord position;
+        simtime_t expiry;
+    };
+
+    std::vector<Entry> entries;
+    simtime_t holdTime;
+    simtime_t earliestExpiry;
+};
+
+#endif
@@ -23,17 +23,61 @@ void RSUApplication::initialize(int stage) {
     BaseWaveApplLayer::initialize(stage);
 
     if (stage == 0) {
+        resultsSink = FindModule<ResultsSink*>::findGlobalModule();
+        broker = FindModule<DisseminationBroker*>::findGlobalModule();
+
+        eventID = par("eventID").longValue();
+        if (eventID < 0)
+            eventID = myId;
+
+        pacingDatarate = registerSignal("pacingDatarate");
+        channelBusyRatio = registerSignal("channelBusyRatio");
+        macQueueLength = registerSignal("macQueueLength");
+        rateDecreases = registerSignal("rateDecreases");
+        achievedDatarate = registerSignal("achievedDatarate");
+
+        HotPathProfiler* profiler = HotPathProfiler::get();
+        if (profiler) {
+            sendDataProfile = profiler->getHandler(getNedTypeName(), "sendData");
+            sendWSMProfile = profiler->getHandler(getNedTypeName(), "sendWSM");
+        }
+
+        std::string pacing = par("pacing").stdstringValue();
+        if (pacing == "fixed")
+            adaptivePacing = false;
+        else if (pacing == "aimd")
+            adaptivePacing = true;
+        else
+            throw cRuntimeError("RSUApplication: unknown pacing mode '%s'", pacing.c_str());
+
+        if (profiler || adaptivePacing) {
+            mac = FindModule<Mac1609_4*>::findSubModule(getParentModule());
+            if (!mac && adaptivePacing)
+                throw cRuntimeError("RSUApplication: adaptive pacing needs a Mac1609_4 in the RSU");
+        }
+
         if (par("sendData").boolValue()) {
             datarate = par("datarate").doubleValue();
+            currentDatarate = datarate;
             disseminationStarted = false;
-            disseminationStartTime = registerSignal("disseminationStartTime");
+
+            if (adaptivePacing) {
+                minDatarate = par("minDatarate").doubleValue();
+                rateIncrease = par("rateIncrease").doubleValue();
+                rateDecrease = par("rateDecrease").doubleValue();
+                targetBusyRatio = par("targetBusyRatio").doubleValue();
+                targetMacQueue = par("targetMacQueue").longValue();
+                pacingInterval = par("pacingInterval").doubleValue();
+                pacingTimer = new cMessage("pacing update", PACING_UPDATE);
+            }
 
             // Schedule end simulation
-            cMessage* m = new cMessage("end simulation", END_SIMULATION);
-            scheduleAt(par("startDataProductionTime").doubleValue() + par("dataTTL").doubleValue(), m);
+            if (par("endSimulationAfterTTL").boolValue()) {
+                cMessage* m = new cMessage("end simulation", END_SIMULATION);
+                scheduleAt(par("startDataProductionTime").doubleValue() + par("dataTTL").doubleValue(), m);
+            }
 
             //TODO: Changed for Game Theory project
-            emit(disseminationStartTime, par("startDataProductionTime").doubleValue());
             disseminationStarted = true;
             readDataFromFile();
             sendDataTimer = new cMessage("Send data", SEND_DATA);
@@ -45,23 +89,17 @@ void RSUApplication::initialize(int stage) {
 void RSUApplication::finish() {
     BaseWaveApplLayer::finish();
 
-    std::ofstream log;
-    std::ostringstream o;
-
-    o << "./results/" << par("log_traffic").longValue() << "-" << par("log_replication").longValue() << "-sender";
-    log.open(o.str().c_str());
-
-    for (std::map<simtime_t, MessageEntryInfo*>::iterator i = loggingInfo.begin(); i != loggingInfo.end(); i++) {
-        simtime_t time = i->first;
-        MessageEntryInfo* videoInfo = i->second;
+    // The interval ends when the last packet starts, so its bits are not part of it
+    if (packetsSent > 1 && lastSendTime > dataStartTime)
+        emit(achievedDatarate, (bitsSent - lastPacketBits) / (lastSendTime - dataStartTime).dbl());
 
-        //tempo \t id n�mero \t udp tamanho
-        log << time << " " << "id " << videoInfo->ID << " " << "udp " << videoInfo->length << endl;
-    }
-    log.close();
+    if (traceReader.getSkippedLines() > 0)
+        recordScalar("traceLinesSkipped", traceReader.getSkippedLines());
 }
 
-RSUApplication::~RSUApplication() {}
+RSUApplication::~RSUApplication() {
+    cancelAndDelete(pacingTimer);
+}
 
 void RSUApplication::handleSelfMsg(cMessage* msg) {
     switch (msg->getKind()) {
@@ -71,9 +109,17 @@ void RSUApplication::handleSelfMsg(cMessage* msg) {
             break;
         }
 
+        case PACING_UPDATE: {
+            updatePacing();
+            break;
+        }
+
         case END_SIMULATION: {
             delete msg;
-            endSimulation();
+
+            // With several RSUs the run lasts until the last dissemination is over
+            if (!broker || broker->closeEvent(eventID))
+                endSimulation();
             break;
         }
 
@@ -87,7 +133,6 @@ void RSUApplication::handleSelfMsg(cMessage* msg) {
 
 void RSUApplication::onBeacon(WaveShortMessage* wsm) {
     if (!disseminationStarted && simTime() >= par("startDataProductionTime")) {
-        emit(disseminationStartTime, simTime());
         disseminationStarted = true;
         readDataFromFile();
         sendDataTimer = new cMessage("Send data", SEND_DATA);
@@ -98,65 +143,173 @@ void RSUApplication::onBeacon(WaveShortMessage* wsm) {
 void RSUApplication::onData(WaveShortMessage* wsm) {}
 
 void RSUApplication::sendData() {
-    if (outputQueue.size() != 0) {
-        MessageEntryInfo* videoInfo = outputQueue.front();
-        outputQueue.pop_front();
+    HotPathProfiler::Scope scope(sendDataProfile);
+
+    if (hasNextPacket) {
+        MessageEntryInfo videoInfo = nextPacket;
 
-        WaveShortMessage* wsm = prepareWSM("data", dataLengthBits, type_SCH, dataPriority, 0, videoInfo->ID);
+        if (packetsSent++ == 0) {
+            dataStartTime = simTime();
+
+            if (adaptivePacing) {
+                lastBusyTime = mac->statsTotalBusyTime;
+                emit(pacingDatarate, currentDatarate);
+                scheduleAt(simTime() + pacingInterval, pacingTimer);
+            }
+
+            // Vehicles inside the ROI from now until the end of the TTL count for the coverage
+            if (broker) {
+                registerEvent();
+                broker->startEvent(eventID);
+            }
+        }
+
+        WaveShortMessage* wsm = prepareWSM("data", dataLengthBits, type_SCH, dataPriority, 0, videoInfo.ID);
 
         // Send first message
         DataMessage* dataMsg = new DataMessage("data");
         dataMsg->setHops(0);
+        dataMsg->setEventID(eventID);
 
         dataMsg->setMessageOriginPosition(curPosition);
         dataMsg->setMessageROI(par("dataROI").doubleValue());
         dataMsg->setMessageOriginTime(simTime());
         dataMsg->setMessageTTL(par("dataTTL"));
 
-        wsm->setBitLength(videoInfo->length);
+        wsm->setBitLength(videoInfo.length);
 
         wsm->encapsulate(dataMsg);
+
+        double nextPktTime = wsm->getBitLength() / currentDatarate;
+
+        bitsSent += wsm->getBitLength();
+        lastPacketBits = wsm->getBitLength();
+        lastSendTime = simTime();
+
         sendWSM(wsm);
 
-        loggingInfo[simTime()] = videoInfo;
+        if (resultsSink) {
+            resultsSink->append(ResultsFormat::SENDER, myId, eventID, simTime(), videoInfo.ID, videoInfo.length, 0, 0);
+        }
+
+        // The next packet is sent when the channel is free at the configured datarate, but not before its time in the trace
+        simtime_t nextSendTime = simTime() + nextPktTime;
+        hasNextPacket = readNextPacket(nextPacket);
+
+        if (hasNextPacket) {
+            simtime_t traceTime = dataStartTime + (nextPacket.time - firstPacketTime);
+            if (traceTime > nextSendTime)
+                nextSendTime = traceTime;
+        }
 
-        double nextPktTime = wsm->getBitLength() / datarate;
-        scheduleAt(simTime() + nextPktTime, sendDataTimer);
+        scheduleAt(nextSendTime, sendDataTimer);
     } else {
+        traceReader.close();
         cancelAndDelete(sendDataTimer);
+
+        if (pacingTimer)
+            cancelEvent(pacingTimer);
     }
 }
 
+void RSUApplication::updatePacing() {
+    simtime_t busyTime = mac->statsTotalBusyTime;
+    double busyRatio = (busyTime - lastBusyTime) / pacingInterval;
+    long queued = HotPathProfiler::estimateMacQueue(mac, framesHandedDown);
+    lastBusyTime = busyTime;
+
+    emit(channelBusyRatio, busyRatio);
+    emit(macQueueLength, queued);
+
+    if (busyRatio > targetBusyRatio || queued > targetMacQueue) {
+        currentDatarate = std::max(currentDatarate * rateDecrease, minDatarate);
+        emit(rateDecreases, 1);
+    } else {
+        currentDatarate = std::min(currentDatarate + rateIncrease, datarate);
+    }
+
+    emit(pacingDatarate, currentDatarate);
+
+    // The packet already scheduled keeps its time, the new rate applies from the next one
+    scheduleAt(simTime() + pacingInterval, pacingTimer);
+}
+
+void RSUApplication::sendWSM(WaveShortMessage* wsm) {
+    if (sendWSMProfile && mac)
+        sendWSMProfile->addFrame(wsm->getByteLength(), HotPathProfiler::estimateMacQueue(mac, framesHandedDown));
+
+    framesHandedDown++;
+
+    BaseWaveApplLayer::sendWSM(wsm);
+}
+
 void RSUApplication::readDataFromFile() {
-    /*std::ifstream sender_trace_file("sender_trace_packets");
-    std::string line;
-
-    int ID;
-    char type;
-    double time;
-    int length;
-    int unknown1;
-    int unknown2;
-
-    while (sender_trace_file >> ID >> type >> time >> length >> unknown1 >> unknown2) {
-        MessageEntryInfo* videoInfo = new MessageEntryInfo;
-        videoInfo->ID = ID;
-        videoInfo->length = length;
-
-        outputQueue.push_back(videoInfo);
-    }*/
-
-    for (int ID = 1; ID <= par("numberPackets").longValue(); ID++) {
-        MessageEntryInfo* videoInfo = new MessageEntryInfo;
-        videoInfo->ID = ID;
-        videoInfo->length = par("packetSize").longValue();
-
-        outputQueue.push_back(videoInfo);
+    std::string traceFile = par("traceFile").stdstringValue();
+
+    useTrace = !traceFile.empty();
+    if (useTrace && !traceReader.open(traceFile))
+        throw cRuntimeError("RSUApplication: cannot open trace file %s", traceFile.c_str());
+
+    numberPackets = par("numberPackets").longValue();
+    packetSize = par("packetSize").longValue();
+    packetsRead = 0;
+    packetsSent = 0;
+
+    hasNextPacket = readNextPacket(nextPacket);
+    firstPacketTime = hasNextPacket ? nextPacket.time : 0;
+}
+
+bool RSUApplication::readNextPacket(MessageEntryInfo& info) {
+    if (useTrace) {
+        VideoTraceReader::Frame frame;
+        long skippedBefore = traceReader.getSkippedLines();
+        bool read = traceReader.next(frame);
+
+        if (!traceReader.getError().empty())
+            throw cRuntimeError("RSUApplication: trace file %s, %s", par("traceFile").stringValue(),
+                    traceReader.getError().c_str());
+
+        // Warned once, the total is recorded at the end
+        if (skippedBefore == 0 && traceReader.getSkippedLines() > 0)
+            EV << "RSUApplication - Warning: skipping malformed lines of trace file " << par("traceFile").stringValue()
+                    << ", the first is line " << traceReader.getFirstSkippedLine() << endl;
+
+        if (!read)
+            return false;
+
+        info.ID = frame.ID;
+        info.length = frame.length;
+        info.time = frame.time;
+    } else {
+        if (packetsRead >= numberPackets)
+            return false;
+
+        // Packets of the same size sent back to back
+        info.ID = packetsRead + 1;
+        info.length = packetSize;
+        info.time = 0;
     }
+
+    packetsRead++;
+
+    return true;
 }
 
 
 void RSUApplication::receiveSignal(cComponent* source, simsignal_t signalID, cObject* obj, cObject* details) {
     Enter_Method_Silent();
     BaseWaveApplLayer::receiveSignal(source, signalID, obj, details);
+
+    // The event is centered on the RSU, whose position is only known from the first mobility update
+    if (signalID == mobilityStateChangedSignal && !eventRegistered && par("sendData").boolValue())
+        registerEvent();
+}
+
+void RSUApplication::registerEvent() {
+    if (!broker || eventRegistered)
+        return;
+
+    broker->registerEvent(eventID, curPosition, par("dataROI").doubleValue(), par("startDataProductionTime").doubleValue(),
+            par("dataTTL").doubleValue());
+    eventRegistered = true;
 }
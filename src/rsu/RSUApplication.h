@@ -19,8 +19,11 @@
 #include "BaseWaveApplLayer.h"
 #include "WaveShortMessage_m.h"
 #include "DataMessage_m.h"
-
-#include <fstream>
+#include "DisseminationBroker.h"
+#include "FindModule.h"
+#include "HotPathProfiler.h"
+#include "ResultsSink.h"
+#include "VideoTraceReader.h"
 
 class RSUApplication : public BaseWaveApplLayer
 {
@@ -29,11 +32,13 @@ private:
     struct MessageEntryInfo {
         int ID;
         int length;
+        double time; // Time of the packet relative to the beginning of the stream
     };
 
     enum {
         SEND_DATA = SEND_BEACON_EVT + 1,
         END_SIMULATION,
+        PACING_UPDATE,
     };
 
 protected:
@@ -41,13 +46,69 @@ protected:
 
     cMessage* sendDataTimer;
 
+    // Configured datarate of the stream. With adaptive pacing it is the maximum and initial rate.
     double datarate;
 
+    // Adaptive pacing: every pacingInterval the share of the interval the channel was busy and the MAC queue
+    // are measured at the RSU's Mac1609_4. If either is above its target the rate is multiplied by
+    // rateDecrease (never below minDatarate), otherwise rateIncrease is added to it (never above datarate).
+    bool adaptivePacing;
+    double currentDatarate;
+    double minDatarate;
+    double rateIncrease;
+    double rateDecrease;
+    double targetBusyRatio;
+    long targetMacQueue;
+    simtime_t pacingInterval;
+    cMessage* pacingTimer;
+    simtime_t lastBusyTime; // statsTotalBusyTime of the MAC at the previous measurement
+
+    // Achieved rate of the stream
+    long bitsSent;
+    long lastPacketBits;
+    simtime_t lastSendTime;
+
+    simsignal_t pacingDatarate; // Rate used for the next packets, in bit/s
+    simsignal_t channelBusyRatio; // Share of the last pacing interval the channel was busy
+    simsignal_t macQueueLength; // Estimated frames waiting in the MAC at the end of a pacing interval
+    simsignal_t rateDecreases; // Indicate a pacing decision that lowered the rate
+    simsignal_t achievedDatarate; // Bits sent before the last packet over the time from the first to the last packet
+
     bool disseminationStarted;
 
-    std::map<simtime_t, MessageEntryInfo*> loggingInfo;
+    // Dissemination event of this RSU. Registered with the broker once the RSU position is known
+    int eventID;
+    bool eventRegistered;
+
+    // Notified when the dissemination starts
+    DisseminationBroker* broker;
+
+    // Sender log
+    ResultsSink* resultsSink;
+
+    // Packets are read one at a time, either from the trace file or generated from numberPackets and packetSize,
+    // so the memory used does not depend on the number of packets of the stream.
+    VideoTraceReader traceReader;
+    bool useTrace;
+    long numberPackets;
+    int packetSize;
+    long packetsRead;
+    long packetsSent;
+
+    MessageEntryInfo nextPacket;
+    bool hasNextPacket;
+
+    // Times at which the stream started, in simulation time and in trace time
+    simtime_t dataStartTime;
+    double firstPacketTime;
+
+    // Hot-path profiling entries, NULL unless the HotPathProfiler is enabled
+    HotPathProfiler::Handler* sendDataProfile;
+    HotPathProfiler::Handler* sendWSMProfile;
 
-    std::list<MessageEntryInfo*> outputQueue;
+    // Only looked up when profiling or pacing adaptively, to measure the channel and the MAC queue
+    Mac1609_4* mac;
+    long framesHandedDown;
 
     virtual void initialize(int stage);
     virtual void finish();
@@ -57,16 +118,18 @@ protected:
     virtual void onData(WaveShortMessage* wsm);
 
     virtual void sendData();
+    virtual void updatePacing();
+    virtual void registerEvent();
+    virtual void sendWSM(WaveShortMessage* wsm);
     virtual void readDataFromFile();
+    virtual bool readNextPacket(MessageEntryInfo& info);
 
     virtual void receiveSignal(cComponent* source, simsignal_t signalID, cObject* obj, cObject* details);
 
 public:
-    // Signal used to inform vehicles that the dissemination has started. Once a vehicle receives the signal, it
-    // verifies whether it is inside the ROI or not. Therefore, this signal is used to identify the vehicles
-    // inside the ROI at the time the dissemination starts. This information is used in the calculation of the
-    // coverage
-    simsignal_t disseminationStartTime;
+    RSUApplication() :
+            adaptivePacing(false), pacingTimer(NULL), bitsSent(0), lastPacketBits(0), eventRegistered(false), packetsSent(0), sendDataProfile(NULL), sendWSMProfile(NULL),
+            mac(NULL), framesHandedDown(0) {}
     ~RSUApplication();
 };
 
@@ -0,0 +1,174 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "VideoTraceReader.h"
+
+#include <cstdlib>
+#include <fcntl.h>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const size_t VideoTraceReader::MAX_TOKEN;
+
+VideoTraceReader::VideoTraceReader() : data(NULL), size(0), offset(0), line(1), skippedLines(0), firstSkippedLine(0) {}
+
+VideoTraceReader::~VideoTraceReader() {
+    close();
+}
+
+bool VideoTraceReader::open(const std::string& fileName) {
+    close();
+
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        ::close(fd);
+        return false;
+    }
+
+    size = st.st_size;
+    offset = 0;
+    line = 1;
+    error.clear();
+    skippedLines = 0;
+    firstSkippedLine = 0;
+
+    if (size > 0) {
+        void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            size = 0;
+            return false;
+        }
+
+        // The trace is read once from the beginning to the end
+        madvise(mapping, size, MADV_SEQUENTIAL);
+        data = (const char*) mapping;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+
+    return true;
+}
+
+void VideoTraceReader::close() {
+    if (data)
+        munmap((void*) data, size);
+
+    data = NULL;
+    size = 0;
+    offset = 0;
+}
+
+bool VideoTraceReader::nextToken(char* buf) {
+    while (offset < size && (data[offset] == ' ' || data[offset] == '\t' || data[offset] == '\r'))
+        offset++;
+
+    if (offset >= size || data[offset] == '\n')
+        return false;
+
+    size_t n = 0;
+    while (offset < size && data[offset] != ' ' && data[offset] != '\t' && data[offset] != '\r' && data[offset] != '\n') {
+        if (n == MAX_TOKEN) {
+            std::ostringstream o;
+            o << "line " << line << ": field longer than " << MAX_TOKEN << " characters";
+            error = o.str();
+            return false;
+        }
+
+        buf[n++] = data[offset];
+        offset++;
+    }
+    buf[n] = '\0';
+
+    return true;
+}
+
+void VideoTraceReader::skipLine() {
+    while (offset < size && data[offset] != '\n')
+        offset++;
+
+    if (offset < size) {
+        offset++;
+        line++;
+    }
+}
+
+void VideoTraceReader::skipMalformedLine() {
+    if (skippedLines == 0)
+        firstSkippedLine = line;
+    skippedLines++;
+
+    skipLine();
+}
+
+bool VideoTraceReader::next(Frame& frame) {
+    char id[MAX_TOKEN + 1], type[MAX_TOKEN + 1], time[MAX_TOKEN + 1], length[MAX_TOKEN + 1];
+    char* end;
+
+    while (offset < size && error.empty()) {
+        // Blank lines are not malformed
+        if (!nextToken(id)) {
+            if (error.empty())
+                skipLine();
+            continue;
+        }
+
+        bool complete = nextToken(type) && nextToken(time) && nextToken(length);
+        if (!error.empty())
+            break;
+
+        if (!complete) {
+            skipMalformedLine();
+            continue;
+        }
+
+        frame.ID = strtol(id, &end, 10);
+        if (*end != '\0') {
+            skipMalformedLine();
+            continue;
+        }
+
+        frame.time = strtod(time, &end);
+        if (*end != '\0') {
+            skipMalformedLine();
+            continue;
+        }
+
+        frame.length = strtol(length, &end, 10);
+        if (*end != '\0') {
+            skipMalformedLine();
+            continue;
+        }
+
+        if (frame.length <= 0) {
+            std::ostringstream o;
+            o << "line " << line << ": packet length " << frame.length << " is not positive";
+            error = o.str();
+            break;
+        }
+
+        skipLine();
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,76 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef _VIDEOTRACEREADER_H_
+#define _VIDEOTRACEREADER_H_
+
+#include <cstddef>
+#include <string>
+
+// Sequential reader for sender trace files (sender_trace_packets). Every line describes one packet:
+//
+//     <ID> <type> <time> <length> <unknown> <unknown>
+//
+// The file is memory-mapped and parsed one line per call to next(), so the memory used does not depend on the
+// length of the trace. Blank lines are ignored. Lines with missing or non-numeric fields are skipped and counted.
+// A field too long to be a number or a length that is not positive stops the reading with an error, since the
+// trace is then corrupt rather than just untidy.
+class VideoTraceReader
+{
+public:
+    struct Frame {
+        int ID;
+        double time; // seconds since the beginning of the trace
+        int length;
+    };
+
+    VideoTraceReader();
+    ~VideoTraceReader();
+
+    // Returns false if the file could not be opened
+    bool open(const std::string& fileName);
+    void close();
+
+    // Reads the next packet. Returns false at the end of the trace or on an error, see getError().
+    bool next(Frame& frame);
+
+    // Description of the error that stopped the reading, empty if none
+    const std::string& getError() const { return error; }
+
+    // Malformed lines skipped so far, and the number of the first one (1-based, 0 if none)
+    long getSkippedLines() const { return skippedLines; }
+    long getFirstSkippedLine() const { return firstSkippedLine; }
+
+private:
+    // Longest field accepted, in characters
+    static const size_t MAX_TOKEN = 31;
+
+    const char* data;
+    size_t size;
+    size_t offset;
+    long line; // Number of the current line, 1-based
+
+    std::string error;
+    long skippedLines;
+    long firstSkippedLine;
+
+    // Copies the next whitespace-separated token of the current line into buf, which holds MAX_TOKEN characters
+    // and the terminator. Returns false at the end of the line, or if the token is too long (and sets error).
+    bool nextToken(char* buf);
+    void skipLine();
+    void skipMalformedLine();
+};
+
+#endif
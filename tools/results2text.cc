@@ -0,0 +1,179 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+// Converts a results file written by ResultsSink into the text logs that Flooding and RSUApplication used to
+// write directly:
+//
+//     <traffic>-<replication>-sender            "<time> id <ID> udp <length>"
+//     <traffic>-<replication>-receiver-<myId>   "<time> id <ID> udp <length> <distance to origin>"
+//
+// If the run had several dissemination events, every event gets its own set of logs, named
+// <traffic>-<replication>-event<eventID>-sender and so on.
+//
+// Usage: results2text <file.rec> [output directory]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ResultsFormat.h"
+
+struct Record {
+    int64_t time;
+    int32_t messageID;
+    int32_t length;
+    double distance;
+
+    bool operator<(const Record& other) const { return messageID < other.messageID; }
+};
+
+// Prints a raw simulation time the same way SimTime does: no trailing zeros and no decimal point for whole seconds
+static std::string formatTime(int64_t raw, int scaleExp) {
+    std::ostringstream o;
+
+    if (raw < 0) {
+        o << "-";
+        raw = -raw;
+    }
+
+    int64_t scale = 1;
+    for (int i = 0; i < -scaleExp; i++)
+        scale *= 10;
+
+    o << raw / scale;
+
+    std::string frac;
+    int64_t rest = raw % scale;
+    for (int i = 0; i < -scaleExp; i++) {
+        scale /= 10;
+        frac += (char) ('0' + (rest / scale) % 10);
+    }
+    frac.erase(frac.find_last_not_of('0') + 1);
+
+    if (!frac.empty())
+        o << "." << frac;
+
+    return o.str();
+}
+
+template<typename T>
+static bool readColumn(FILE* f, std::vector<T>& column, uint32_t rows) {
+    column.resize(rows);
+    return fread(&column[0], sizeof(T), rows, f) == rows;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <file.rec> [output directory]" << std::endl;
+        return 1;
+    }
+
+    std::string outputDir = argc > 2 ? argv[2] : ".";
+
+    FILE* f = fopen(argv[1], "rb");
+    if (!f) {
+        std::cerr << "Cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    ResultsFormat::FileHeader header;
+    if (fread(&header, sizeof(header), 1, f) != 1 || memcmp(header.magic, ResultsFormat::MAGIC, sizeof(header.magic))
+            || header.version != ResultsFormat::VERSION) {
+        std::cerr << argv[1] << " is not a results file" << std::endl;
+        fclose(f);
+        return 1;
+    }
+
+    // Sender and receiver records, by event
+    std::map<int32_t, std::vector<Record> > sent;
+    std::map<int32_t, std::map<int32_t, std::vector<Record> > > received;
+
+    std::vector<int64_t> times;
+    std::vector<int32_t> messageIDs, lengths, hops, nodeIds, eventIDs;
+    std::vector<double> distances;
+    std::vector<uint8_t> types;
+
+    uint32_t rows;
+    while (fread(&rows, sizeof(rows), 1, f) == 1) {
+        if (!readColumn(f, times, rows) || !readColumn(f, messageIDs, rows) || !readColumn(f, lengths, rows)
+                || !readColumn(f, distances, rows) || !readColumn(f, hops, rows) || !readColumn(f, nodeIds, rows)
+                || !readColumn(f, eventIDs, rows) || !readColumn(f, types, rows)) {
+            std::cerr << argv[1] << " is truncated" << std::endl;
+            fclose(f);
+            return 1;
+        }
+
+        for (uint32_t i = 0; i < rows; i++) {
+            Record r;
+            r.time = times[i];
+            r.messageID = messageIDs[i];
+            r.length = lengths[i];
+            r.distance = distances[i];
+
+            if (types[i] == ResultsFormat::SENDER)
+                sent[eventIDs[i]].push_back(r);
+            else
+                received[eventIDs[i]][nodeIds[i]].push_back(r);
+        }
+    }
+    fclose(f);
+
+    std::set<int32_t> events;
+    for (std::map<int32_t, std::vector<Record> >::iterator e = sent.begin(); e != sent.end(); e++)
+        events.insert(e->first);
+    for (std::map<int32_t, std::map<int32_t, std::vector<Record> > >::iterator e = received.begin(); e != received.end(); e++)
+        events.insert(e->first);
+
+    for (std::set<int32_t>::iterator e = events.begin(); e != events.end(); e++) {
+        std::ostringstream prefix;
+        prefix << outputDir << "/" << header.traffic << "-" << header.replication;
+
+        // A single event keeps the names of the original logs
+        if (events.size() > 1)
+            prefix << "-event" << *e;
+
+        std::vector<Record>& eventSent = sent[*e];
+
+        if (!eventSent.empty()) {
+            std::ofstream log((prefix.str() + "-sender").c_str());
+
+            for (std::vector<Record>::iterator i = eventSent.begin(); i != eventSent.end(); i++)
+                log << formatTime(i->time, header.timeScaleExp) << " " << "id " << i->messageID << " " << "udp " << i->length << std::endl;
+        }
+
+        std::map<int32_t, std::vector<Record> >& eventReceived = received[*e];
+
+        for (std::map<int32_t, std::vector<Record> >::iterator n = eventReceived.begin(); n != eventReceived.end(); n++) {
+            std::ostringstream name;
+            name << prefix.str() << "-receiver-" << n->first;
+            std::ofstream log(name.str().c_str());
+
+            // Receiver logs are ordered by message ID
+            std::stable_sort(n->second.begin(), n->second.end());
+
+            for (std::vector<Record>::iterator i = n->second.begin(); i != n->second.end(); i++)
+                log << formatTime(i->time, header.timeScaleExp) << " " << "id " << i->messageID << " " << "udp " << i->length << " " << i->distance << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,381 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+// Computes the dissemination metrics of a whole campaign from the results files written by ResultsSink, so
+// that the per-host text logs do not have to be produced and parsed. Every file is streamed block by block
+// and the receptions are joined with the transmissions of the same event by message ID; the memory needed
+// per file is one entry per message sent and per receiving host, plus fixed-size histograms. The files are
+// analyzed in parallel, one per thread.
+//
+// For every run and every dissemination event it reports:
+//
+//     messages    messages sent by the RSU
+//     receivers   hosts that received at least one message
+//     coverage    fraction of the receivers that received every message
+//     delivery    fraction of the (receiver, message) pairs that were received
+//     delay       end-to-end delay from transmission at the RSU to first reception, in s
+//     hops        number of hops at first reception
+//     goodput     bytes received per receiver, over the time from the first transmission to the last
+//                 reception, in kbit/s
+//
+// Hosts that never received a message do not appear in the results file; the coverage of the vehicles in
+// the ROI is recorded by DisseminationBroker (event<id>.coverage).
+//
+// The runs whose file names differ only in the trailing "-<log_replication>.rec" form a configuration; files
+// named otherwise are grouped by directory and log_traffic. For every configuration and event the per-run
+// values are averaged with the half-width of their 95% confidence interval, and the delay and hop percentiles
+// are computed from the merged histograms of all its runs.
+//
+// The output is CSV on stdout, one line per configuration and event, preceded by one line per run and event
+// with -r.
+//
+// Usage: resultsstats [-j threads] [-r] <file.rec>...
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LogHistogram.h"
+#include "ResultsFormat.h"
+
+// Delays are counted in microseconds up to one hour, hops one by one
+static const double DELAY_UNIT = 1e-6;
+static const double MAX_DELAY = 3600;
+static const double MAX_HOPS = 1024;
+
+struct EventStats {
+    // Transmission time at the RSU of every message, in s
+    std::map<int32_t, double> sendTimes;
+
+    // Number of messages received, by host
+    std::map<int32_t, int32_t> receptions;
+
+    LogHistogram delay;
+    LogHistogram hops;
+
+    uint64_t bytesReceived;
+    uint64_t unmatched; // Receptions of messages without a transmission record
+    double firstSend;
+    double lastReception;
+
+    EventStats() :
+            delay(DELAY_UNIT, MAX_DELAY), hops(1, MAX_HOPS), bytesReceived(0), unmatched(0), firstSend(0), lastReception(0) {}
+};
+
+// Metrics of one event in one run
+struct EventSummary {
+    int32_t event;
+    size_t messages;
+    size_t receivers;
+    double coverage;
+    double delivery;
+    double goodput;
+    uint64_t unmatched;
+    LogHistogram delay;
+    LogHistogram hops;
+};
+
+struct RunSummary {
+    std::string fileName;
+    std::string configuration;
+    std::string error;
+    std::vector<EventSummary> events;
+};
+
+template<typename T>
+static bool readColumn(FILE* f, std::vector<T>& column, uint32_t rows) {
+    column.resize(rows);
+    return rows == 0 || fread(&column[0], sizeof(T), rows, f) == rows;
+}
+
+static std::string directoryOf(const std::string& path) {
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos ? "." : path.substr(0, slash);
+}
+
+static std::string configurationOf(const std::string& fileName, const ResultsFormat::FileHeader& header) {
+    std::ostringstream suffix;
+    suffix << "-" << header.replication << ".rec";
+    size_t length = suffix.str().size();
+
+    if (fileName.size() > length && fileName.compare(fileName.size() - length, length, suffix.str()) == 0)
+        return fileName.substr(0, fileName.size() - length);
+
+    std::ostringstream configuration;
+    configuration << directoryOf(fileName) << "/" << header.traffic;
+    return configuration.str();
+}
+
+static void summarize(int32_t event, EventStats& stats, EventSummary& summary) {
+    summary.event = event;
+    summary.messages = stats.sendTimes.size();
+    summary.receivers = stats.receptions.size();
+    summary.unmatched = stats.unmatched;
+    summary.delay = stats.delay;
+    summary.hops = stats.hops;
+
+    size_t complete = 0;
+    uint64_t received = 0;
+    for (std::map<int32_t, int32_t>::iterator i = stats.receptions.begin(); i != stats.receptions.end(); i++) {
+        received += i->second;
+        if ((size_t) i->second >= summary.messages)
+            complete++;
+    }
+
+    summary.coverage = summary.receivers ? (double) complete / summary.receivers : 0;
+    summary.delivery = summary.receivers && summary.messages ? (double) received / (summary.receivers * summary.messages) : 0;
+
+    double duration = stats.lastReception - stats.firstSend;
+    summary.goodput = summary.receivers && duration > 0 ? stats.bytesReceived * 8 / 1000.0 / summary.receivers / duration : 0;
+}
+
+static void analyze(const std::string& fileName, RunSummary& run) {
+    run.fileName = fileName;
+
+    FILE* f = fopen(fileName.c_str(), "rb");
+    if (!f) {
+        run.error = "cannot open " + fileName;
+        return;
+    }
+
+    ResultsFormat::FileHeader header;
+    if (fread(&header, sizeof(header), 1, f) != 1 || memcmp(header.magic, ResultsFormat::MAGIC, sizeof(header.magic))
+            || header.version != ResultsFormat::VERSION) {
+        run.error = fileName + " is not a results file";
+        fclose(f);
+        return;
+    }
+
+    run.configuration = configurationOf(fileName, header);
+
+    double timeScale = std::pow(10.0, header.timeScaleExp);
+
+    std::map<int32_t, EventStats> events;
+
+    std::vector<int64_t> times;
+    std::vector<int32_t> messageIDs, lengths, hops, nodeIds, eventIDs;
+    std::vector<double> distances;
+    std::vector<uint8_t> types;
+
+    uint32_t rows;
+    while (fread(&rows, sizeof(rows), 1, f) == 1) {
+        if (!readColumn(f, times, rows) || !readColumn(f, messageIDs, rows) || !readColumn(f, lengths, rows)
+                || !readColumn(f, distances, rows) || !readColumn(f, hops, rows) || !readColumn(f, nodeIds, rows)
+                || !readColumn(f, eventIDs, rows) || !readColumn(f, types, rows)) {
+            run.error = fileName + " is truncated";
+            fclose(f);
+            return;
+        }
+
+        for (uint32_t i = 0; i < rows; i++) {
+            EventStats& stats = events[eventIDs[i]];
+            double time = times[i] * timeScale;
+
+            if (types[i] == ResultsFormat::SENDER) {
+                if (stats.sendTimes.empty() || time < stats.firstSend)
+                    stats.firstSend = time;
+                stats.sendTimes[messageIDs[i]] = time;
+                continue;
+            }
+
+            // The sink writes the records in time order, so the transmission of a message is always read
+            // before its receptions
+            std::map<int32_t, double>::iterator sent = stats.sendTimes.find(messageIDs[i]);
+            if (sent == stats.sendTimes.end()) {
+                stats.unmatched++;
+                continue;
+            }
+
+            stats.receptions[nodeIds[i]]++;
+            stats.delay.add(time - sent->second);
+            stats.hops.add(hops[i]);
+            stats.bytesReceived += lengths[i];
+
+            if (time > stats.lastReception)
+                stats.lastReception = time;
+        }
+    }
+    fclose(f);
+
+    for (std::map<int32_t, EventStats>::iterator e = events.begin(); e != events.end(); e++) {
+        run.events.push_back(EventSummary());
+        summarize(e->first, e->second, run.events.back());
+    }
+}
+
+// Two-sided 95% quantile of Student's t distribution
+static double studentT95(size_t degreesOfFreedom) {
+    static const double table[] = { 0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228, 2.201,
+            2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056,
+            2.052, 2.048, 2.045, 2.042 };
+
+    if (degreesOfFreedom < sizeof(table) / sizeof(table[0]))
+        return table[degreesOfFreedom];
+    return degreesOfFreedom <= 60 ? 2.000 : 1.960;
+}
+
+// Mean of a per-run metric and the half-width of its 95% confidence interval
+class Sample
+{
+public:
+    Sample() : n(0), sum(0), sumSquares(0) {}
+
+    void add(double value) {
+        n++;
+        sum += value;
+        sumSquares += value * value;
+    }
+
+    double mean() const { return n ? sum / n : 0; }
+
+    double halfWidth() const {
+        if (n < 2)
+            return 0;
+
+        double variance = std::max((sumSquares - sum * sum / n) / (n - 1), 0.0);
+        return studentT95(n - 1) * std::sqrt(variance / n);
+    }
+
+private:
+    size_t n;
+    double sum;
+    double sumSquares;
+};
+
+struct ConfigurationStats {
+    size_t runs;
+    uint64_t unmatched;
+    Sample messages, receivers, coverage, delivery, meanDelay, meanHops, goodput;
+    LogHistogram delay;
+    LogHistogram hops;
+
+    ConfigurationStats() : runs(0), unmatched(0), delay(DELAY_UNIT, MAX_DELAY), hops(1, MAX_HOPS) {}
+
+    void add(const EventSummary& e) {
+        runs++;
+        unmatched += e.unmatched;
+        messages.add(e.messages);
+        receivers.add(e.receivers);
+        coverage.add(e.coverage);
+        delivery.add(e.delivery);
+        meanDelay.add(e.delay.mean());
+        meanHops.add(e.hops.mean());
+        goodput.add(e.goodput);
+        delay.merge(e.delay);
+        hops.merge(e.hops);
+    }
+};
+
+static void printHeader() {
+    std::cout << "scope,name,event,runs,messages,receivers,coverage,coverage_ci,delivery,delivery_ci,"
+            << "delay_mean,delay_mean_ci,delay_p50,delay_p90,delay_p99,delay_max,hops_mean,hops_mean_ci,hops_p50,hops_p99,"
+            << "hops_max,goodput_kbps,goodput_kbps_ci,unmatched" << std::endl;
+}
+
+static void printRun(const RunSummary& run, const EventSummary& e) {
+    std::cout << "run," << run.fileName << "," << e.event << ",1," << e.messages << "," << e.receivers << ","
+            << e.coverage << ",0," << e.delivery << ",0," << e.delay.mean() << ",0," << e.delay.percentile(0.5) << ","
+            << e.delay.percentile(0.9) << "," << e.delay.percentile(0.99) << "," << e.delay.max() << "," << e.hops.mean()
+            << ",0," << e.hops.percentile(0.5) << "," << e.hops.percentile(0.99) << "," << e.hops.max() << "," << e.goodput
+            << ",0," << e.unmatched << std::endl;
+}
+
+static void printConfiguration(const std::string& name, int32_t event, const ConfigurationStats& c) {
+    std::cout << "configuration," << name << "," << event << "," << c.runs << "," << c.messages.mean() << ","
+            << c.receivers.mean() << "," << c.coverage.mean() << "," << c.coverage.halfWidth() << "," << c.delivery.mean()
+            << "," << c.delivery.halfWidth() << "," << c.meanDelay.mean() << "," << c.meanDelay.halfWidth() << ","
+            << c.delay.percentile(0.5) << "," << c.delay.percentile(0.9) << "," << c.delay.percentile(0.99) << ","
+            << c.delay.max() << "," << c.meanHops.mean() << "," << c.meanHops.halfWidth() << "," << c.hops.percentile(0.5)
+            << "," << c.hops.percentile(0.99) << "," << c.hops.max() << "," << c.goodput.mean() << ","
+            << c.goodput.halfWidth() << "," << c.unmatched << std::endl;
+}
+
+static void usage(const char* name) {
+    std::cerr << "Usage: " << name << " [-j threads] [-r] <file.rec>..." << std::endl;
+}
+
+int main(int argc, char** argv) {
+    size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+    bool printRuns = false;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = std::max(atoi(argv[++i]), 1);
+        } else if (strcmp(argv[i], "-r") == 0) {
+            printRuns = true;
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 1;
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+
+    if (files.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // Every worker takes the next file not analyzed yet
+    std::vector<RunSummary> runs(files.size());
+    std::atomic<size_t> nextFile(0);
+    std::vector<std::thread> workers;
+
+    for (size_t t = 0; t < std::min(threads, files.size()); t++) {
+        workers.push_back(std::thread([&]() {
+            for (size_t i = nextFile++; i < files.size(); i = nextFile++)
+                analyze(files[i], runs[i]);
+        }));
+    }
+
+    for (size_t t = 0; t < workers.size(); t++)
+        workers[t].join();
+
+    int status = 0;
+    std::map<std::string, std::map<int32_t, ConfigurationStats> > configurations;
+
+    printHeader();
+
+    for (std::vector<RunSummary>::iterator r = runs.begin(); r != runs.end(); r++) {
+        if (!r->error.empty()) {
+            std::cerr << r->error << std::endl;
+            status = 1;
+            continue;
+        }
+
+        for (std::vector<EventSummary>::iterator e = r->events.begin(); e != r->events.end(); e++) {
+            if (printRuns)
+                printRun(*r, *e);
+            configurations[r->configuration][e->event].add(*e);
+        }
+    }
+
+    for (std::map<std::string, std::map<int32_t, ConfigurationStats> >::iterator c = configurations.begin();
+            c != configurations.end(); c++) {
+        for (std::map<int32_t, ConfigurationStats>::iterator e = c->second.begin(); e != c->second.end(); e++)
+            printConfiguration(c->first, e->first, e->second);
+    }
+
+    return status;
+}